@@ -0,0 +1,122 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BandTransferBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QElapsedTimer>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Host/Gimp/BandTransfer.h"
+#include "gmic.h"
+
+/*
+ * Time spent by the GIMP host transferring a layer from and to a GEGL
+ * buffer, as a function of the number of pixels per band. GEGL is replaced
+ * by a stand-in storing interleaved pixels in 128x64 tiles, GEGL's default
+ * tile size, so that the figures show the cost of the layout conversion and
+ * of the copies across tiles. The largest band holds the whole layer, as
+ * done before the transfer by bands.
+ *
+ * Usage: band_transfer_benchmark [width height]
+ */
+
+namespace
+{
+class TiledBuffer {
+public:
+  static const int TileWidth = 128;
+  static const int TileHeight = 64;
+  TiledBuffer(int width, int height, int spectrum)
+      : _width(width), _spectrum(spectrum), _tilesPerRow((width + TileWidth - 1) / TileWidth),
+        _tiles(static_cast<size_t>(_tilesPerRow) * ((height + TileHeight - 1) / TileHeight) * TileWidth * TileHeight * spectrum)
+  {
+  }
+  // Copy the rows [y, y + rows), interleaved, to or from data
+  void get(int y, int rows, float * data) const
+  {
+    for (int row = y; row < y + rows; ++row) {
+      for (int x = 0; x < _width; x += TileWidth) {
+        const int count = std::min(TileWidth, _width - x) * _spectrum;
+        std::memcpy(data, pixel(x, row), count * sizeof(float));
+        data += count;
+      }
+    }
+  }
+  void set(int y, int rows, const float * data)
+  {
+    for (int row = y; row < y + rows; ++row) {
+      for (int x = 0; x < _width; x += TileWidth) {
+        const int count = std::min(TileWidth, _width - x) * _spectrum;
+        std::memcpy(const_cast<float *>(pixel(x, row)), data, count * sizeof(float));
+        data += count;
+      }
+    }
+  }
+
+private:
+  const float * pixel(int x, int y) const
+  {
+    const size_t tile = static_cast<size_t>(y / TileHeight) * _tilesPerRow + x / TileWidth;
+    return _tiles.data() + (tile * TileHeight * TileWidth + static_cast<size_t>(y % TileHeight) * TileWidth + x % TileWidth) * _spectrum;
+  }
+  int _width;
+  int _spectrum;
+  int _tilesPerRow;
+  std::vector<float> _tiles;
+};
+}
+
+int main(int argc, char * argv[])
+{
+  const int width = (argc > 2) ? std::max(1, QString(argv[1]).toInt()) : 4000;
+  const int height = (argc > 2) ? std::max(1, QString(argv[2]).toInt()) : 3000;
+  const int spectrum = 4;
+  gmic_image<float> layer(width, height, 1, spectrum);
+  layer.rand(0, 255);
+  TiledBuffer buffer(width, height, spectrum);
+  std::printf("%dx%d RGBA layer\n", width, height);
+
+  const int bandPixels[] = {16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4096 * 1024, width * height};
+  for (int pixels : bandPixels) {
+    if (pixels > width * height) {
+      continue;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    BandTransfer::write(layer, [&buffer](int y, int rows, const float * data) { buffer.set(y, rows, data); }, pixels);
+    const double writeTime = timer.nsecsElapsed() / 1e6;
+    gmic_image<float> result;
+    timer.start();
+    BandTransfer::read(width, height, spectrum, [&buffer](int y, int rows, float * data) { buffer.get(y, rows, data); }, result, pixels);
+    const double readTime = timer.nsecsElapsed() / 1e6;
+    if (!result.is_sameXYZC(layer) || (result - layer).abs().max() > 1e-3f) {
+      std::fprintf(stderr, "Band transfer altered the layer\n");
+      return 1;
+    }
+    const size_t bandBytes = static_cast<size_t>(std::min(height, BandTransfer::bandRows(width, pixels))) * width * spectrum * sizeof(float);
+    std::printf("%8d pixels per band (%6.1f MiB temporary): write %7.1f ms, read %7.1f ms\n", pixels, bandBytes / 1048576.0, writeTime, readTime);
+  }
+  return 0;
+}
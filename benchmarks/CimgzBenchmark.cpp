@@ -0,0 +1,122 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CimgzBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include "Updater.h"
+#include "Utils.h"
+#include "gmic.h"
+
+/*
+ * Time spent decompressing the stdlib update file (update<version>.cimgz):
+ * from a QByteArray and from the mapped file, as done by the Updater, and
+ * through a temporary file and CImg<>::load_cimg(), as done before.
+ *
+ * Usage: cimgz_benchmark [file.cimgz]
+ *
+ * Without argument, the file downloaded by the plug-in is used if present.
+ * Otherwise, the stdlib built in G'MIC is compressed into a temporary file.
+ */
+
+namespace
+{
+QByteArray loadCimgThroughTemporaryFile(const QByteArray & array)
+{
+  QTemporaryFile tmpZ(QDir::tempPath() + QDir::separator() + "gmic_qt_update_XXXXXX_cimgz");
+  if (!tmpZ.open()) {
+    return QByteArray();
+  }
+  tmpZ.write(array);
+  tmpZ.flush();
+  tmpZ.close();
+  gmic_image<unsigned char> buffer;
+  try {
+    buffer.load_cimg(tmpZ.fileName().toLocal8Bit().constData());
+  } catch (...) {
+    return QByteArray();
+  }
+  return QByteArray((char *)buffer.data(), static_cast<int>(buffer.size()));
+}
+
+double median(QVector<double> times)
+{
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  QString filename = (argc > 1) ? QString(argv[1]) : QString("%1update%2.cimgz").arg(GmicQt::path_rc(false)).arg(gmic_version);
+  QTemporaryFile builtIn(QDir::tempPath() + QDir::separator() + "gmic_qt_stdlib_XXXXXX.cimgz");
+  if (!QFileInfo(filename).isReadable()) {
+    if (argc > 1 || !builtIn.open()) {
+      std::fprintf(stderr, "Cannot read %s\n", filename.toLocal8Bit().constData());
+      return 1;
+    }
+    builtIn.close();
+    gmic::decompress_stdlib().save_cimg(builtIn.fileName().toLocal8Bit().constData(), true);
+    filename = builtIn.fileName();
+    std::printf("Built-in stdlib, compressed into a temporary file\n");
+  }
+  QFile file(filename);
+  if (!file.open(QFile::ReadOnly)) {
+    std::fprintf(stderr, "Cannot read %s\n", filename.toLocal8Bit().constData());
+    return 1;
+  }
+  const QByteArray array = file.readAll();
+  const QByteArray expected = loadCimgThroughTemporaryFile(array);
+  if (expected.isEmpty() || Updater::cimgzDecompress(array) != expected || Updater::cimgzDecompressFile(filename) != expected) {
+    std::fprintf(stderr, "Decompressed data differ from CImg<>::load_cimg()\n");
+    return 1;
+  }
+
+  const int rounds = 20;
+  QVector<double> memoryTimes, mappedTimes, temporaryFileTimes;
+  QElapsedTimer timer;
+  for (int round = 0; round < rounds; ++round) {
+    timer.start();
+    Updater::cimgzDecompress(array);
+    memoryTimes.push_back(timer.nsecsElapsed() / 1e6);
+    timer.start();
+    Updater::cimgzDecompressFile(filename);
+    mappedTimes.push_back(timer.nsecsElapsed() / 1e6);
+    timer.start();
+    loadCimgThroughTemporaryFile(array);
+    temporaryFileTimes.push_back(timer.nsecsElapsed() / 1e6);
+  }
+  std::printf("%s: %d bytes, %d bytes decompressed\n", filename.toLocal8Bit().constData(), array.size(), expected.size());
+  std::printf("From memory: %.2f ms, from the mapped file: %.2f ms, through a temporary file: %.2f ms (medians of %d rounds)\n", median(memoryTimes), median(mappedTimes),
+              median(temporaryFileTimes), rounds);
+  return 0;
+}
@@ -0,0 +1,110 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ConversionScalingBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QElapsedTimer>
+#include <QImage>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "ImageConverter.h"
+#include "ImageTools.h"
+#include "gmic.h"
+#ifdef cimg_use_openmp
+#include <omp.h>
+#endif
+
+/*
+ * Scaling of the parallel conversions (ImageConverter::convert() and the
+ * in-place GmicQt::image2uchar()) from 1 to N threads, on an RGBA and an
+ * RGB image.
+ *
+ * Usage: conversion_scaling_benchmark [megapixels] [runs]
+ */
+
+namespace
+{
+struct Timings {
+  double toQImage;
+  double fromQImage;
+  double toUchar;
+};
+
+Timings bestTimings(const gmic_image<float> & image, int runs)
+{
+  Timings best = {-1, -1, -1};
+  QElapsedTimer timer;
+  QImage qimage;
+  gmic_image<float> result;
+  gmic_image<float> copy;
+  for (int run = 0; run < runs; ++run) {
+    timer.start();
+    ImageConverter::convert(image, qimage);
+    const double toQImage = timer.nsecsElapsed() / 1e6;
+    timer.start();
+    ImageConverter::convert(qimage, result);
+    const double fromQImage = timer.nsecsElapsed() / 1e6;
+    copy = image;
+    timer.start();
+    GmicQt::image2uchar(copy);
+    const double toUchar = timer.nsecsElapsed() / 1e6;
+    best.toQImage = (best.toQImage < 0) ? toQImage : std::min(best.toQImage, toQImage);
+    best.fromQImage = (best.fromQImage < 0) ? fromQImage : std::min(best.fromQImage, fromQImage);
+    best.toUchar = (best.toUchar < 0) ? toUchar : std::min(best.toUchar, toUchar);
+  }
+  return best;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  const int megapixels = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 32;
+  const int runs = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 5;
+#ifdef cimg_use_openmp
+  const int maxThreads = omp_get_num_procs();
+#else
+  const int maxThreads = 1;
+  std::printf("Built without OpenMP: conversions are sequential\n");
+#endif
+  const int width = 4096;
+  const int height = (megapixels * 1024 * 1024) / width;
+  for (int spectrum = 4; spectrum >= 3; --spectrum) {
+    gmic_image<float> image(width, height, 1, spectrum);
+    image.rand(0, 255);
+    std::printf("\n%dx%d, %d channels\n", width, height, spectrum);
+    std::printf("%-8s %16s %16s %16s\n", "Threads", "to QImage (ms)", "from QImage (ms)", "image2uchar (ms)");
+    Timings single = {0, 0, 0};
+    for (int threads = 1; threads <= maxThreads; threads = (threads < maxThreads) ? std::min(2 * threads, maxThreads) : (threads + 1)) {
+#ifdef cimg_use_openmp
+      omp_set_num_threads(threads);
+#endif
+      const Timings timings = bestTimings(image, runs);
+      if (threads == 1) {
+        single = timings;
+      }
+      std::printf("%-8d %9.2f (%4.1fx) %9.2f (%4.1fx) %9.2f (%4.1fx)\n", threads, timings.toQImage, single.toQImage / timings.toQImage, timings.fromQImage,
+                  single.fromQImage / timings.fromQImage, timings.toUchar, single.toUchar / timings.toUchar);
+    }
+  }
+  return 0;
+}
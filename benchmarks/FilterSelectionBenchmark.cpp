@@ -0,0 +1,128 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterSelectionBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QApplication>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include "FilterParameters/FilterParametersWidget.h"
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "GmicStdlib.h"
+
+/*
+ * 500 consecutive filter selections (FilterParametersWidget::build() over
+ * the filters of the stdlib, in order), with the parameter widgets recycled
+ * by the widget pool, and with a new FilterParametersWidget per selection
+ * (every widget allocated, as without the pool). Reports the time and the
+ * number of heap allocations per selection.
+ *
+ * Usage: filter_selection_benchmark [selections]
+ */
+
+#if defined(__GLIBC__)
+// Count every heap allocation, whether made by operator new or by Qt containers
+namespace
+{
+std::atomic<unsigned long> allocationCount(0);
+}
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * pointer, size_t size);
+void * malloc(size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+void * calloc(size_t count, size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+void * realloc(void * pointer, size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(pointer, size);
+}
+}
+#define ALLOCATIONS allocationCount.load()
+#else
+#define ALLOCATIONS 0ul
+#endif
+
+namespace
+{
+struct Result {
+  double milliseconds;
+  unsigned long allocations;
+};
+
+Result selectFilters(const FiltersModel & model, int selections, bool recycle)
+{
+  QWidget window;
+  FilterParametersWidget * widget = new FilterParametersWidget(&window);
+  QElapsedTimer timer;
+  const unsigned long allocations = ALLOCATIONS;
+  timer.start();
+  for (int selection = 0; selection < selections; ++selection) {
+    const FiltersModel::Filter & filter = model.getFilter(selection % model.filterCount());
+    if (!recycle) {
+      delete widget;
+      widget = new FilterParametersWidget(&window);
+    }
+    widget->build(filter.name(), filter.hash(), filter.parameters(), QList<QString>());
+    QApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+  }
+  Result result;
+  result.milliseconds = timer.nsecsElapsed() / 1e6;
+  result.allocations = ALLOCATIONS - allocations;
+  return result;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+  const int selections = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 500;
+  GmicStdLib::loadStdLib();
+  FiltersModel model;
+  FiltersModelReader(model).parseFiltersDefinitions(GmicStdLib::Array);
+  if (!model.filterCount()) {
+    std::fprintf(stderr, "No filter found in the stdlib\n");
+    return 1;
+  }
+  selectFilters(model, std::min(selections, 50), true); // Warm up (schema cache, fonts, styles)
+  const Result pooled = selectFilters(model, selections, true);
+  const Result allocated = selectFilters(model, selections, false);
+#if !defined(__GLIBC__)
+  std::printf("Allocations are only counted with the GNU C library\n");
+#endif
+  std::printf("%d selections      %12s %18s\n", selections, "Time (ms)", "Allocations/sel.");
+  std::printf("Widget pool         %12.2f %18.1f\n", pooled.milliseconds, pooled.allocations / double(selections));
+  std::printf("New widgets         %12.2f %18.1f\n", allocated.milliseconds, allocated.allocations / double(selections));
+  return 0;
+}
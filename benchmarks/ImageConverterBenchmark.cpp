@@ -0,0 +1,167 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ImageConverterBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QElapsedTimer>
+#include <QImage>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include "ImageConverter.h"
+#include "gmic.h"
+#ifdef cimg_use_openmp
+#include <omp.h>
+#endif
+
+/*
+ * ImageConverter::convert() (SSE2/AVX2 kernels) against the scalar loops it
+ * replaced, at 4K and 8K, for each number of channels and both directions.
+ * Conversions run on a single thread, so that only the kernels are compared.
+ *
+ * Usage: image_converter_benchmark [runs]
+ */
+
+namespace
+{
+// The per-pixel loops of ImageConverter before vectorization
+void referenceConvert(const gmic_image<float> & in, QImage & out)
+{
+  const QImage::Format formats[] = {QImage::Format_Grayscale8, QImage::Format_Grayscale8, QImage::Format_ARGB32, QImage::Format_RGB888, QImage::Format_ARGB32};
+  out = QImage(in.width(), in.height(), formats[in.spectrum()]);
+  const float * src0 = in.data(0, 0, 0, 0);
+  const float * src1 = in.data(0, 0, 0, std::min(1, in.spectrum() - 1));
+  const float * src2 = in.data(0, 0, 0, std::min(2, in.spectrum() - 1));
+  const float * src3 = in.data(0, 0, 0, std::min(3, in.spectrum() - 1));
+  for (int y = 0; y < out.height(); ++y) {
+    int n = in.width();
+    unsigned char * dst = out.scanLine(y);
+    if (in.spectrum() == 4) {
+      while (n--) {
+        dst[0] = static_cast<unsigned char>(*src2++);
+        dst[1] = static_cast<unsigned char>(*src1++);
+        dst[2] = static_cast<unsigned char>(*src0++);
+        dst[3] = static_cast<unsigned char>(*src3++);
+        dst += 4;
+      }
+    } else if (in.spectrum() == 3) {
+      while (n--) {
+        dst[0] = static_cast<unsigned char>(*src0++);
+        dst[1] = static_cast<unsigned char>(*src1++);
+        dst[2] = static_cast<unsigned char>(*src2++);
+        dst += 3;
+      }
+    } else if (in.spectrum() == 2) {
+      while (n--) {
+        dst[2] = dst[1] = dst[0] = static_cast<unsigned char>(*src0++);
+        dst[3] = static_cast<unsigned char>(*src1++);
+        dst += 4;
+      }
+    } else {
+      while (n--) {
+        *dst++ = static_cast<unsigned char>(*src0++);
+      }
+    }
+  }
+}
+
+void referenceConvert(const QImage & in, gmic_image<float> & out)
+{
+  const int spectrum = (in.format() == QImage::Format_ARGB32) ? 4 : 3;
+  out.assign(in.width(), in.height(), 1, spectrum);
+  float * dst0 = out.data(0, 0, 0, 0);
+  float * dst1 = out.data(0, 0, 0, 1);
+  float * dst2 = out.data(0, 0, 0, 2);
+  float * dst3 = out.data(0, 0, 0, spectrum - 1);
+  for (int y = 0; y < in.height(); ++y) {
+    const unsigned char * src = in.scanLine(y);
+    int n = in.width();
+    if (spectrum == 4) {
+      while (n--) {
+        *dst2++ = static_cast<float>(src[0]);
+        *dst1++ = static_cast<float>(src[1]);
+        *dst0++ = static_cast<float>(src[2]);
+        *dst3++ = static_cast<float>(src[3]);
+        src += 4;
+      }
+    } else {
+      while (n--) {
+        *dst0++ = static_cast<float>(src[0]);
+        *dst1++ = static_cast<float>(src[1]);
+        *dst2++ = static_cast<float>(src[2]);
+        src += 3;
+      }
+    }
+  }
+}
+
+// Best time of several runs, in milliseconds
+double bestTime(int runs, const std::function<void()> & function)
+{
+  double best = -1;
+  QElapsedTimer timer;
+  for (int run = 0; run < runs; ++run) {
+    timer.start();
+    function();
+    const double ms = timer.nsecsElapsed() / 1e6;
+    best = (best < 0) ? ms : std::min(best, ms);
+  }
+  return best;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  const int runs = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 5;
+#ifdef cimg_use_openmp
+  omp_set_num_threads(1);
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  std::printf("AVX2 kernels: %s\n", __builtin_cpu_supports("avx2") ? "yes" : "no (SSE2)");
+#endif
+  const struct {
+    const char * name;
+    int width;
+    int height;
+  } sizes[] = {{"4K", 3840, 2160}, {"8K", 7680, 4320}};
+  std::printf("%-4s %-16s %12s %12s %8s\n", "Size", "Conversion", "Scalar (ms)", "SIMD (ms)", "Speedup");
+  for (const auto & size : sizes) {
+    for (int spectrum = 1; spectrum <= 4; ++spectrum) {
+      gmic_image<float> image(size.width, size.height, 1, spectrum);
+      image.rand(0, 255);
+      QImage qimage;
+      const double scalar = bestTime(runs, [&]() { referenceConvert(image, qimage); });
+      const double simd = bestTime(runs, [&]() { ImageConverter::convert(image, qimage); });
+      std::printf("%-4s %-16s %12.2f %12.2f %7.2fx\n", size.name, QString("float%1 -> QImage").arg(spectrum).toLatin1().constData(), scalar, simd, scalar / simd);
+      if (spectrum >= 3) {
+        gmic_image<float> result;
+        const double scalarBack = bestTime(runs, [&]() { referenceConvert(qimage, result); });
+        const double simdBack = bestTime(runs, [&]() { ImageConverter::convert(qimage, result); });
+        std::printf("%-4s %-16s %12.2f %12.2f %7.2fx\n", size.name, QString("QImage -> float%1").arg(spectrum).toLatin1().constData(), scalarBack, simdBack, scalarBack / simdBack);
+      }
+    }
+  }
+  return 0;
+}
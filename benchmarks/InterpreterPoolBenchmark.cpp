@@ -0,0 +1,98 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file InterpreterPoolBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "FilterThread.h"
+#include "GmicInterpreterPool.h"
+#include "GmicStdlib.h"
+#include "gmic.h"
+
+/*
+ * Per-preview overhead of a FilterThread, with a new interpreter for each
+ * run (no pool) and with interpreters taken from a GmicInterpreterPool.
+ * The filter is trivial and the image tiny, so that the measured time is
+ * mostly the cost of getting an interpreter ready.
+ *
+ * Usage: interpreter_pool_benchmark [runs]
+ */
+
+namespace
+{
+const char * Command = "blur";
+const char * Arguments = "0.5";
+const char * Environment = "_input_layers=1 _output_mode=0 _output_messages=0 _preview_mode=0 _preview_width=400 _preview_height=300 _preview_timeout=16";
+
+double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+std::vector<double> runPreviews(GmicInterpreterPool * pool, int runs)
+{
+  gmic_list<float> images(1);
+  gmic_list<char> imageNames(1);
+  images[0].assign(64, 64, 1, 3).rand(0, 255);
+  gmic_image<char>::string("pos(0,0),name(benchmark)").move_to(imageNames[0]);
+  std::vector<double> durations;
+  QElapsedTimer timer;
+  for (int run = 0; run < runs; ++run) {
+    FilterThread thread(nullptr, "Benchmark", Command, Arguments, Environment, GmicQt::Quiet);
+    thread.setInterpreterPool(pool);
+    thread.setInputImages(images);
+    thread.setImageNames(imageNames);
+    timer.start();
+    thread.start();
+    thread.wait();
+    durations.push_back(timer.nsecsElapsed() / 1e6);
+    if (thread.failed()) {
+      std::fprintf(stderr, "Error: %s\n", thread.errorMessage().toLocal8Bit().constData());
+      std::exit(1);
+    }
+  }
+  return durations;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  const int runs = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 50;
+  GmicStdLib::loadStdLib();
+
+  const std::vector<double> fresh = runPreviews(nullptr, runs);
+  GmicInterpreterPool pool;
+  const std::vector<double> pooled = runPreviews(&pool, runs);
+
+  std::printf("Per-preview time, '%s %s' on 64x64x3, %d runs\n", Command, Arguments, runs);
+  std::printf("  new interpreter per run : median %8.2f ms\n", median(fresh));
+  std::printf("  pooled interpreter      : median %8.2f ms (first run %.2f ms, %d interpreter(s) built)\n", median(pooled), pooled.front(), pool.createdCount());
+  return 0;
+}
@@ -0,0 +1,91 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KritaRoundTripBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include "Host/Krita/KritaClient.h"
+#include "MockKritaServer.h"
+#include "gmic.h"
+
+/*
+ * Round-trip time of a get_layers_extent + get_cropped_images exchange with
+ * the mock Krita server, with one connection per message (protocol 1) and
+ * with a session (protocol 2). A preview-sized crop shows the latency of the
+ * channel itself, the full layer adds the copy out of the shared memory.
+ *
+ * Usage: krita_round_trip_benchmark [rounds]
+ */
+
+namespace
+{
+void measure(int protocol, const gmic_image<float> & layer, int rounds)
+{
+  const QString key = QString("gmic-qt-krita-benchmark-%1-%2").arg(QCoreApplication::applicationPid()).arg(protocol);
+  MockKritaServer server(key, protocol, layer);
+  if (!server.listen()) {
+    std::fprintf(stderr, "Could not start the mock server\n");
+    return;
+  }
+  KritaClient client(key);
+  client.protocol();
+  const double crops[2] = {0.25, -1.0};
+  for (double crop : crops) {
+    QVector<double> times;
+    QElapsedTimer timer;
+    for (int round = 0; round < rounds; ++round) {
+      timer.start();
+      int width, height;
+      gmic_list<float> images;
+      gmic_list<char> names;
+      client.getLayersExtent(1, width, height);
+      if (crop > 0) {
+        client.getCroppedImages(1, 0.375, 0.375, crop, crop, images, names);
+      } else {
+        client.getCroppedImages(1, 0.0, 0.0, 1.0, 1.0, images, names);
+      }
+      times.push_back(timer.nsecsElapsed() / 1e3);
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("protocol %d, %s: median %.1f us, max %.1f us (%d connections)\n", protocol, (crop > 0) ? "preview crop" : "full layer", times[times.size() / 2], times.back(),
+                server.connectionCount());
+  }
+  client.close();
+}
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  const int rounds = (argc > 1) ? std::max(1, QString(argv[1]).toInt()) : 200;
+  gmic_image<float> layer(1024, 1024, 1, 4);
+  cimg_forXYC(layer, x, y, c) { layer(x, y, 0, c) = float((x + y + c) % 256); }
+  std::printf("%d rounds, 1024x1024 RGBA layer\n", rounds);
+  measure(1, layer, rounds);
+  measure(2, layer, rounds);
+  return 0;
+}
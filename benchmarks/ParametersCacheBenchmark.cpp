@@ -0,0 +1,129 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParametersCacheBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+#include <QTemporaryDir>
+#include <cstdio>
+#include "Globals.h"
+#include "InputOutputState.h"
+#include "ParametersCache.h"
+#include "Utils.h"
+
+/*
+ * Time spent loading and saving a synthetic parameters cache of 10k filters
+ * (8 parameters each, a fifth of them with an In/Out state): full snapshot,
+ * journal of a single change, save after values and states were set again
+ * unchanged, and load of the snapshot with a 1000-record journal.
+ *
+ * Usage: parameters_cache_benchmark
+ */
+
+namespace
+{
+const int EntryCount = 10000;
+
+QString hash(int index)
+{
+  return QString("%1").arg(index, 32, 16, QChar('0'));
+}
+
+QList<QString> values(int index, int version)
+{
+  QList<QString> list;
+  for (int i = 0; i < 8; ++i) {
+    list.push_back(QString::number(0.5 * index + i + version));
+  }
+  return list;
+}
+
+const GmicQt::InputOutputState State(GmicQt::All, GmicQt::NewLayers, GmicQt::FirstOutput, GmicQt::Quiet);
+
+qint64 fileSize(const char * filename)
+{
+  return QFileInfo(QString("%1%2").arg(GmicQt::path_rc(false), filename)).size();
+}
+
+void report(const char * what, QElapsedTimer & timer)
+{
+  std::printf("%-52s %8.2f ms, snapshot %8lld bytes, journal %7lld bytes\n", what, timer.nsecsElapsed() / 1e6, fileSize(PARAMETERS_CACHE_FILENAME), fileSize(PARAMETERS_CACHE_JOURNAL_FILENAME));
+}
+}
+
+int main(int argc, char * argv[])
+{
+  // Keep the cache files away from the user's ones
+  QTemporaryDir home;
+  qputenv("GMIC_PATH", home.path().toLocal8Bit());
+  qputenv("XDG_CONFIG_HOME", home.path().toLocal8Bit());
+  QCoreApplication app(argc, argv);
+  if (GmicQt::path_rc(true).isEmpty()) {
+    std::fprintf(stderr, "Could not create the resources directory\n");
+    return 1;
+  }
+  QElapsedTimer timer;
+
+  ParametersCache::load(true);
+  for (int i = 0; i < EntryCount; ++i) {
+    ParametersCache::setValues(hash(i), values(i, 0));
+    if (!(i % 5)) {
+      ParametersCache::setInputOutputState(hash(i), State);
+    }
+  }
+  timer.start();
+  ParametersCache::save();
+  report("Save of 10k new entries (snapshot)", timer);
+
+  timer.start();
+  ParametersCache::load(true);
+  report("Load of the snapshot", timer);
+
+  ParametersCache::setValues(hash(42), values(42, 1));
+  timer.start();
+  ParametersCache::save();
+  report("Save of a single change (journal)", timer);
+
+  for (int i = 0; i < EntryCount; i += 100) {
+    ParametersCache::setValues(hash(i), ParametersCache::getValues(hash(i)));
+    ParametersCache::setInputOutputState(hash(i), ParametersCache::getInputOutputState(hash(i)));
+  }
+  timer.start();
+  ParametersCache::save();
+  report("Save after setting 100 entries again, unchanged", timer);
+
+  timer.start();
+  for (int i = 0; i < 1000; ++i) {
+    ParametersCache::setValues(hash(i), values(i, 2));
+    ParametersCache::save();
+  }
+  report("1000 saves of a single change", timer);
+
+  timer.start();
+  ParametersCache::load(true);
+  report("Load of the snapshot and a 1000-record journal", timer);
+  return 0;
+}
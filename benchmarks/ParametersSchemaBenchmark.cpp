@@ -0,0 +1,94 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParametersSchemaBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include "FilterParameters/ParametersSchema.h"
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "GmicStdlib.h"
+
+/*
+ * Time spent getting the parameters schema of every filter of the stdlib:
+ * compiled from the text, then from the cache (the cache only holds the
+ * most recently used filters, hence the separate figure for the largest ones).
+ *
+ * Usage: parameters_schema_benchmark
+ */
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  GmicStdLib::loadStdLib();
+  FiltersModel model;
+  FiltersModelReader(model).parseFiltersDefinitions(GmicStdLib::Array);
+  const size_t count = model.filterCount();
+  if (!count) {
+    std::fprintf(stderr, "No filter found in the stdlib\n");
+    return 1;
+  }
+  QElapsedTimer timer;
+
+  timer.start();
+  int parameters = 0;
+  for (size_t index = 0; index < count; ++index) {
+    parameters += ParametersSchema::compile(model.getFilter(index).parameters()).parameters().size();
+  }
+  const double compileTime = timer.nsecsElapsed() / 1e6;
+
+  // Filters with 30+ parameters, selected over and over
+  QList<size_t> largeFilters;
+  for (size_t index = 0; index < count; ++index) {
+    const FiltersModel::Filter & filter = model.getFilter(index);
+    if (ParametersSchema::get(filter.hash(), filter.parameters()).actualParametersCount() >= 30) {
+      largeFilters.push_back(index);
+    }
+  }
+  const int rounds = 100;
+  timer.start();
+  for (int round = 0; round < rounds; ++round) {
+    for (size_t index : largeFilters) {
+      const FiltersModel::Filter & filter = model.getFilter(index);
+      ParametersSchema::compile(filter.parameters());
+    }
+  }
+  const double largeCompileTime = timer.nsecsElapsed() / 1e6;
+  timer.start();
+  for (int round = 0; round < rounds; ++round) {
+    for (size_t index : largeFilters) {
+      const FiltersModel::Filter & filter = model.getFilter(index);
+      ParametersSchema::get(filter.hash(), filter.parameters());
+    }
+  }
+  const double largeCachedTime = timer.nsecsElapsed() / 1e6;
+
+  std::printf("%zu filters, %d parameters: %.2f ms to compile all schemas\n", count, parameters, compileTime);
+  if (!largeFilters.isEmpty()) {
+    const double selections = double(rounds) * largeFilters.size();
+    std::printf("%d filters with 30+ parameters, per selection: compiled %.1f us, cached %.1f us\n", largeFilters.size(), 1000.0 * largeCompileTime / selections,
+                1000.0 * largeCachedTime / selections);
+  }
+  return 0;
+}
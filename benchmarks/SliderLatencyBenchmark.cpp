@@ -0,0 +1,186 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file SliderLatencyBenchmark.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "GmicProcessor.h"
+#include "GmicStdlib.h"
+#include "HostStub.h"
+#include "gmic.h"
+
+/*
+ * Slider-to-pixels latency of the preview while a slider is dragged: one
+ * value change every 16 ms, then the slider is released. For each value,
+ * the latency is the time until a preview computed for that value (or a
+ * later one) is available. The filter fills its output with the value,
+ * which tells which value a preview was computed for.
+ *
+ * Speculative: GmicProcessor::speculate() on each change, full preview on release.
+ * Debounced: full preview once the parameter timer (300 ms) expires, as before.
+ *
+ * Usage: slider_latency_benchmark [steps] [filter command]
+ */
+
+namespace
+{
+const int ChangeInterval = 16;  // ms
+const int UpdateDelay = 300;    // ms, FloatParameter::UPDATE_DELAY
+const int DragTimeout = 120000; // ms
+
+struct Drag {
+  std::vector<qint64> changed;
+  std::vector<qint64> shown;
+  qint64 released;
+  qint64 finalShown;
+};
+
+GmicProcessor::FilterContext filterContext(const QString & command, int value)
+{
+  GmicProcessor::FilterContext context;
+  context.requestType = GmicProcessor::FilterContext::PreviewProcessing;
+  context.visibleRect = {0.0, 0.0, 1.0, 1.0};
+  context.inputOutputState = GmicQt::InputOutputState(GmicQt::Active, GmicQt::InPlace, GmicQt::FirstOutput, GmicQt::Quiet);
+  context.positionStringCorrection = {1.0, 1.0};
+  context.previewWidth = HostStub::InputImage.width() / 2;
+  context.previewHeight = HostStub::InputImage.height() / 2;
+  context.zoomFactor = 0.5;
+  context.previewTimeout = 16;
+  context.filterName = "Slider latency";
+  context.filterCommand = command;
+  context.filterArguments = QString::number(value);
+  context.progressivePreview = false;
+  context.tiledProcessing = false;
+  context.tileSize = 1024;
+  context.tileHalo = 0;
+  return context;
+}
+
+Drag drag(const QString & command, int steps, bool speculative)
+{
+  GmicProcessor processor;
+  processor.init();
+  Drag drag;
+  drag.changed.assign(steps + 1, -1);
+  drag.shown.assign(steps + 1, -1);
+  drag.released = -1;
+  drag.finalShown = -1;
+  QElapsedTimer clock;
+  QEventLoop loop;
+  QTimer slider;
+  QTimer parameterTimer;
+  parameterTimer.setSingleShot(true);
+  parameterTimer.setInterval(UpdateDelay);
+  int value = 0;
+
+  auto shownValue = [&]() {
+    const cimg_library::CImg<float> & image = processor.previewImage();
+    const int shown = image.is_empty() ? 0 : static_cast<int>(std::round(image(0, 0)));
+    const qint64 now = clock.elapsed();
+    for (int v = 1; v <= std::min(shown, steps); ++v) {
+      if (drag.shown[v] < 0) {
+        drag.shown[v] = now;
+      }
+    }
+    return shown;
+  };
+  QObject::connect(&processor, &GmicProcessor::speculativePreviewImageAvailable, shownValue);
+  QObject::connect(&processor, &GmicProcessor::previewImageAvailable, [&]() {
+    if ((shownValue() == steps) && (drag.released >= 0)) {
+      drag.finalShown = clock.elapsed();
+      loop.quit();
+    }
+  });
+  QObject::connect(&processor, &GmicProcessor::previewCommandFailed, [&](QString message) {
+    std::fprintf(stderr, "Error: %s\n", message.toLocal8Bit().constData());
+    std::exit(1);
+  });
+  QObject::connect(&parameterTimer, &QTimer::timeout, [&]() {
+    processor.setContext(filterContext(command, value));
+    processor.execute();
+  });
+  QObject::connect(&slider, &QTimer::timeout, [&]() {
+    if (value < steps) {
+      drag.changed[++value] = clock.elapsed();
+      if (speculative) {
+        processor.speculate(filterContext(command, value));
+      } else {
+        parameterTimer.start();
+      }
+      return;
+    }
+    // Release: the speculative mode sends the value at once, the former one waits for the timer
+    slider.stop();
+    drag.released = clock.elapsed();
+    if (speculative) {
+      processor.setContext(filterContext(command, value));
+      processor.execute();
+    }
+  });
+  QTimer::singleShot(DragTimeout, &loop, SLOT(quit()));
+  clock.start();
+  slider.start(ChangeInterval);
+  loop.exec();
+  processor.cancel();
+  return drag;
+}
+
+void report(const char * mode, const Drag & drag)
+{
+  std::vector<qint64> latencies;
+  for (size_t v = 1; v < drag.changed.size(); ++v) {
+    if ((drag.changed[v] >= 0) && (drag.shown[v] >= 0)) {
+      latencies.push_back(drag.shown[v] - drag.changed[v]);
+    }
+  }
+  if (latencies.empty() || (drag.finalShown < 0)) {
+    std::printf("%-12s timed out\n", mode);
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("%-12s %12lld %12lld %20lld\n", mode, static_cast<long long>(latencies[latencies.size() / 2]), static_cast<long long>(latencies.back()),
+              static_cast<long long>(drag.finalShown - drag.released));
+}
+}
+
+int main(int argc, char * argv[])
+{
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+  const int steps = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 60;
+  const QString command = (argc > 2) ? QString(argv[2]) + " fill" : QString("blur 5 fill");
+  GmicStdLib::loadStdLib();
+  HostStub::InputImage.assign(1920, 1080, 1, 4).rand(0, 255);
+  std::printf("%d values, one every %d ms, preview of '%s' on a 1920x1080 layer\n", steps, ChangeInterval, command.toLocal8Bit().constData());
+  std::printf("%-12s %12s %12s %20s\n", "Mode", "Median (ms)", "Max (ms)", "Release to final (ms)");
+  report("Debounced", drag(command, steps, false));
+  report("Speculative", drag(command, steps, true));
+  return 0;
+}
@@ -142,6 +142,7 @@ linux {
 equals( HOST, "gimp") {
  TARGET = gmic_gimp_qt
  SOURCES += src/Host/Gimp/host_gimp.cpp
+ HEADERS += src/Host/Gimp/BandTransfer.h
  DEFINES += GMIC_HOST=gimp_qt
  DEFINES += GIMP_DISABLE_DEPRECATED
  DEPENDPATH += $$PWD/src/Host/Gimp
@@ -153,7 +154,9 @@ equals( HOST, "none") {
  TARGET = gmic_qt
  DEFINES += GMIC_HOST=standalone
  SOURCES += src/Host/None/host_none.cpp
+ SOURCES += src/Host/None/BatchProcessor.cpp
  SOURCES += src/Host/None/ImageDialog.cpp
+ HEADERS += src/Host/None/BatchProcessor.h
  HEADERS += src/Host/None/ImageDialog.h
  DEPENDPATH += $$PWD/src/Host/None
  message(Building standalone version)
@@ -162,6 +165,8 @@ equals( HOST, "none") {
 equals( HOST, "krita") {
  TARGET = gmic_krita_qt
  SOURCES += src/Host/Krita/host_krita.cpp
+ SOURCES += src/Host/Krita/KritaClient.cpp
+ HEADERS += src/Host/Krita/KritaClient.h
  DEFINES += GMIC_HOST=krita
  DEPENDPATH += $$PWD/src/Host/Krita
  message(Target host software is Krita)
@@ -227,8 +232,12 @@ HEADERS +=  \
   src/FilterParameters/LinkParameter.h \
   src/FilterParameters/MultilineTextParameterWidget.h \
   src/FilterParameters/NoteParameter.h \
+  src/FilterParameters/ParametersSchema.h \
   src/FilterParameters/SeparatorParameter.h \
   src/FilterParameters/TextParameter.h \
+  src/FilterParameters/WidgetPool.h \
+  src/FilterSelector/FiltersCatalogueCache.h \
+  src/FilterSelector/FiltersCatalogueThread.h \
   src/FilterSelector/FiltersModel.h \
   src/FilterSelector/FiltersModelReader.h \
   src/FilterSelector/FiltersPresenter.h \
@@ -238,18 +247,21 @@ HEADERS +=  \
   src/FilterThread.h \
   src/gmic_qt.h \
   src/Globals.h \
+  src/GmicInterpreterPool.h \
   src/GmicStdlib.h \
   src/GmicProcessor.h \
   src/HeadlessProcessor.h \
   src/Host/host.h \
   src/HtmlTranslator.h \
   src/ImageConverter.h \
+  src/ImagePyramid.h \
   src/ImageTools.h \
   src/InputOutputState.h \
   src/LayersExtentProxy.h \
   src/Logger.h \
   src/MainWindow.h \
   src/ParametersCache.h \
+  src/PreviewCache.h \
   src/PreviewMode.h \
   src/TimeLogger.h \
   src/Updater.h \
@@ -292,8 +304,12 @@ SOURCES += \
   src/FilterParameters/LinkParameter.cpp \
   src/FilterParameters/MultilineTextParameterWidget.cpp \
   src/FilterParameters/NoteParameter.cpp \
+  src/FilterParameters/ParametersSchema.cpp \
   src/FilterParameters/SeparatorParameter.cpp \
   src/FilterParameters/TextParameter.cpp \
+  src/FilterParameters/WidgetPool.cpp \
+  src/FilterSelector/FiltersCatalogueCache.cpp \
+  src/FilterSelector/FiltersCatalogueThread.cpp \
   src/FilterSelector/FiltersModel.cpp \
   src/FilterSelector/FiltersModelReader.cpp \
   src/FilterSelector/FiltersPresenter.cpp \
@@ -303,17 +319,20 @@ SOURCES += \
   src/FilterThread.cpp \
   src/gmic_qt.cpp \
   src/Globals.cpp \
+  src/GmicInterpreterPool.cpp \
   src/GmicStdlib.cpp \
   src/GmicProcessor.cpp \
   src/HeadlessProcessor.cpp \
   src/HtmlTranslator.cpp \
   src/ImageConverter.cpp \
+  src/ImagePyramid.cpp \
   src/ImageTools.cpp \
   src/InputOutputState.cpp \
   src/LayersExtentProxy.cpp \
   src/Logger.cpp \
   src/MainWindow.cpp \
   src/ParametersCache.cpp \
+  src/PreviewCache.cpp \
   src/PreviewMode.cpp \
   src/TimeLogger.cpp \
   src/Updater.cpp \
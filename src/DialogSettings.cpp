@@ -28,6 +28,7 @@
 #include <limits>
 #include "Common.h"
 #include "Globals.h"
+#include "PreviewCache.h"
 #include "Updater.h"
 #include "ui_dialogsettings.h"
 
@@ -45,6 +46,11 @@ QColor DialogSettings::UnselectedFilterTextColor;
 QString DialogSettings::FolderParameterDefaultValue;
 QString DialogSettings::FileParameterDefaultPath;
 int DialogSettings::_previewTimeout = 16;
+int DialogSettings::_previewCacheSize = 256;
+bool DialogSettings::_progressivePreview = true;
+bool DialogSettings::_tiledProcessing = false;
+int DialogSettings::_tileSize = 2048;
+int DialogSettings::_tileHalo = 32;
 
 // TODO : Make DialogSetting a view of a Settings class
 
@@ -73,6 +79,9 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
   }
 
   ui->sbPreviewTimeout->setRange(1, 360);
+  ui->sbPreviewCacheSize->setRange(0, 4096);
+  ui->sbTileSize->setRange(256, 16384);
+  ui->sbTileHalo->setRange(0, 1024);
 
   ui->rbLeftPreview->setChecked(_previewPosition == MainWindow::PreviewOnLeft);
   ui->rbRightPreview->setChecked(_previewPosition == MainWindow::PreviewOnRight);
@@ -83,6 +92,14 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
   ui->cbNativeColorDialogs->setToolTip(tr("Check to use Native/OS color dialog, uncheck to use Qt's"));
   ui->cbShowLogos->setChecked(_logosAreVisible);
   ui->sbPreviewTimeout->setValue(_previewTimeout);
+  ui->sbPreviewCacheSize->setValue(_previewCacheSize);
+  ui->cbProgressivePreview->setChecked(_progressivePreview);
+  ui->cbProgressivePreview->setToolTip(tr("Show low resolution previews of slow filters while the full preview is computed"));
+  ui->cbTiledProcessing->setChecked(_tiledProcessing);
+  ui->cbTiledProcessing->setToolTip(tr("Apply filters that support it tile by tile on images larger than the tile size"));
+  ui->sbTileSize->setValue(_tileSize);
+  ui->sbTileHalo->setValue(_tileHalo);
+  ui->labelPreviewCacheStats->setText(tr("%1 previews (%2 MB), %3 hits, %4 misses").arg(PreviewCache::count()).arg(PreviewCache::size()).arg(PreviewCache::hits()).arg(PreviewCache::misses()));
 
   connect(ui->pbOk, SIGNAL(clicked()), this, SLOT(onOk()));
   connect(ui->rbLeftPreview, SIGNAL(toggled(bool)), this, SLOT(onRadioLeftPreviewToggled(bool)));
@@ -103,6 +120,16 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
 
   connect(ui->sbPreviewTimeout, SIGNAL(valueChanged(int)), this, SLOT(onPreviewTimeoutChange(int)));
 
+  connect(ui->sbPreviewCacheSize, SIGNAL(valueChanged(int)), this, SLOT(onPreviewCacheSizeChange(int)));
+
+  connect(ui->cbProgressivePreview, SIGNAL(toggled(bool)), this, SLOT(onProgressivePreviewToggled(bool)));
+
+  connect(ui->cbTiledProcessing, SIGNAL(toggled(bool)), this, SLOT(onTiledProcessingToggled(bool)));
+
+  connect(ui->sbTileSize, SIGNAL(valueChanged(int)), this, SLOT(onTileSizeChange(int)));
+
+  connect(ui->sbTileHalo, SIGNAL(valueChanged(int)), this, SLOT(onTileHaloChange(int)));
+
   ui->languageSelector->selectLanguage(_languageCode);
   if (_darkThemeEnabled) {
     QPalette p = ui->cbNativeColorDialogs->palette();
@@ -115,6 +142,8 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
     ui->rbLeftPreview->setPalette(p);
     ui->rbRightPreview->setPalette(p);
     ui->cbShowLogos->setPalette(p);
+    ui->cbProgressivePreview->setPalette(p);
+    ui->cbTiledProcessing->setPalette(p);
   }
   ui->pbOk->setFocus();
 }
@@ -140,6 +169,12 @@ void DialogSettings::loadSettings()
   FileParameterDefaultPath = settings.value("FileParameterDefaultPath", QDir::homePath()).toString();
   _logosAreVisible = settings.value("LogosAreVisible", true).toBool();
   _previewTimeout = settings.value("PreviewTimeout", 16).toInt();
+  _previewCacheSize = settings.value("PreviewCacheSize", 256).toInt();
+  PreviewCache::setMaxSize(_previewCacheSize);
+  _progressivePreview = settings.value("ProgressivePreview", true).toBool();
+  _tiledProcessing = settings.value("TiledProcessing", false).toBool();
+  _tileSize = settings.value("TileSize", 2048).toInt();
+  _tileHalo = settings.value("TileHalo", 32).toInt();
 }
 
 int DialogSettings::previewTimeout()
@@ -147,6 +182,31 @@ int DialogSettings::previewTimeout()
   return _previewTimeout;
 }
 
+int DialogSettings::previewCacheSize()
+{
+  return _previewCacheSize;
+}
+
+bool DialogSettings::progressivePreview()
+{
+  return _progressivePreview;
+}
+
+bool DialogSettings::tiledProcessing()
+{
+  return _tiledProcessing;
+}
+
+int DialogSettings::tileSize()
+{
+  return _tileSize;
+}
+
+int DialogSettings::tileHalo()
+{
+  return _tileHalo;
+}
+
 void DialogSettings::saveSettings(QSettings & settings)
 {
   settings.setValue("Config/PreviewPosition", (_previewPosition == MainWindow::PreviewOnLeft) ? "Left" : "Right");
@@ -156,6 +216,11 @@ void DialogSettings::saveSettings(QSettings & settings)
   settings.setValue("FileParameterDefaultPath", FileParameterDefaultPath);
   settings.setValue("LogosAreVisible", _logosAreVisible);
   settings.setValue("PreviewTimeout", _previewTimeout);
+  settings.setValue("PreviewCacheSize", _previewCacheSize);
+  settings.setValue("ProgressivePreview", _progressivePreview);
+  settings.setValue("TiledProcessing", _tiledProcessing);
+  settings.setValue("TileSize", _tileSize);
+  settings.setValue("TileHalo", _tileHalo);
 
   // Remove obsolete keys (2.0.0 pre-release)
   settings.remove("Config/UseFaveInputMode");
@@ -198,6 +263,32 @@ void DialogSettings::onPreviewTimeoutChange(int value)
   _previewTimeout = value;
 }
 
+void DialogSettings::onPreviewCacheSizeChange(int value)
+{
+  _previewCacheSize = value;
+  PreviewCache::setMaxSize(value);
+}
+
+void DialogSettings::onProgressivePreviewToggled(bool on)
+{
+  _progressivePreview = on;
+}
+
+void DialogSettings::onTiledProcessingToggled(bool on)
+{
+  _tiledProcessing = on;
+}
+
+void DialogSettings::onTileSizeChange(int value)
+{
+  _tileSize = value;
+}
+
+void DialogSettings::onTileHaloChange(int value)
+{
+  _tileHalo = value;
+}
+
 void DialogSettings::enableUpdateButton()
 {
   ui->pbUpdate->setEnabled(true);
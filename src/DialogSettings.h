@@ -56,6 +56,11 @@ public:
   static QString FolderParameterDefaultValue;
   static QString FileParameterDefaultPath;
   static int previewTimeout();
+  static int previewCacheSize();
+  static bool progressivePreview();
+  static bool tiledProcessing();
+  static int tileSize();
+  static int tileHalo();
 
 public slots:
   void onRadioLeftPreviewToggled(bool);
@@ -68,6 +73,11 @@ public slots:
   void done(int r) override;
   void onLogosVisibleToggled(bool);
   void onPreviewTimeoutChange(int);
+  void onPreviewCacheSizeChange(int);
+  void onProgressivePreviewToggled(bool);
+  void onTiledProcessingToggled(bool);
+  void onTileSizeChange(int);
+  void onTileHaloChange(int);
 
 private:
   Ui::DialogSettings * ui;
@@ -78,6 +88,11 @@ private:
   static int _updatePeriodicity;
   static bool _logosAreVisible;
   static int _previewTimeout;
+  static int _previewCacheSize;
+  static bool _progressivePreview;
+  static bool _tiledProcessing;
+  static int _tileSize;
+  static int _tileHalo;
 };
 
 #endif // _GMIC_QT_DIALOGSETTINGS_H_
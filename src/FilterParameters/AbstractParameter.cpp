@@ -24,7 +24,6 @@
  */
 #include "FilterParameters/AbstractParameter.h"
 #include <QDebug>
-#include <cstring>
 #include "Common.h"
 #include "FilterParameters/BoolParameter.h"
 #include "FilterParameters/ButtonParameter.h"
@@ -40,7 +39,7 @@
 #include "FilterParameters/SeparatorParameter.h"
 #include "FilterParameters/TextParameter.h"
 
-AbstractParameter::AbstractParameter(QObject * parent, bool actualParameter) : QObject(parent), _actualParameter(actualParameter), _update(true)
+AbstractParameter::AbstractParameter(QObject * parent, bool actualParameter) : QObject(parent), _actualParameter(actualParameter), _update(true), _widgetPool(0)
 {
 }
 
@@ -68,110 +67,90 @@ void AbstractParameter::clear()
   // Used to clear the value of a ButtonParameter
 }
 
-AbstractParameter * AbstractParameter::createFromText(const char * text, int & length, QString & error, QObject * parent)
+AbstractParameter * AbstractParameter::createFromSchema(const ParametersSchema::Parameter & parameter, QString & error, QObject * parent)
 {
   AbstractParameter * result = 0;
-  QString line = text;
   error.clear();
-
-#define PREFIX "^[^=]*\\s*=\\s*_?"
-  if (QRegExp(PREFIX "int", Qt::CaseInsensitive).indexIn(line) == 0) {
+  switch (parameter.type) {
+  case ParametersSchema::IntType:
     result = new IntParameter(parent);
-  } else if (QRegExp(PREFIX "float", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::FloatType:
     result = new FloatParameter(parent);
-  } else if (QRegExp(PREFIX "bool", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::BoolType:
     result = new BoolParameter(parent);
-  } else if (QRegExp(PREFIX "choice", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::ChoiceType:
     result = new ChoiceParameter(parent);
-  } else if (QRegExp(PREFIX "color", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::ColorType:
     result = new ColorParameter(parent);
-  } else if (QRegExp(PREFIX "separator", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::SeparatorType:
     result = new SeparatorParameter(parent);
-  } else if (QRegExp(PREFIX "note", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::NoteType:
     result = new NoteParameter(parent);
-  } else if (QRegExp(PREFIX "file", Qt::CaseInsensitive).indexIn(line) == 0 || QRegExp(PREFIX "filein", Qt::CaseInsensitive).indexIn(line) == 0 ||
-             QRegExp(PREFIX "fileout", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::FileType:
+  case ParametersSchema::FileInType:
+  case ParametersSchema::FileOutType:
     result = new FileParameter(parent);
-  } else if (QRegExp(PREFIX "folder", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::FolderType:
     result = new FolderParameter(parent);
-  } else if (QRegExp(PREFIX "text", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::TextType:
     result = new TextParameter(parent);
-  } else if (QRegExp(PREFIX "link", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::LinkType:
     result = new LinkParameter(parent);
-  } else if (QRegExp(PREFIX "value", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::ValueType:
     result = new ConstParameter(parent);
-  } else if (QRegExp(PREFIX "button", Qt::CaseInsensitive).indexIn(line) == 0) {
+    break;
+  case ParametersSchema::ButtonType:
     result = new ButtonParameter(parent);
+    break;
   }
-  if (result) {
-    if (!result->initFromText(text, length)) {
-      delete result;
-      result = nullptr;
-      if (!line.isEmpty()) {
-        QRegExp nameRegExp("^[^=]*\\s*=");
-        if (nameRegExp.indexIn(line) == 0) {
-          QString name = nameRegExp.cap(0).remove(QRegExp("=$"));
-          error = "Parameter name: " + name + "\n" + error;
-        }
-      }
-    }
-  } else {
-    if (!line.isEmpty()) {
-      QRegExp nameRegExp("^[^=]*\\s*=");
-      if (nameRegExp.indexIn(line) == 0) {
-        QString name = nameRegExp.cap(0).remove(QRegExp("=$"));
-        QRegExp typeRegExp("^[^=]*\\s*=\\s*_?([^\\( ]*)\\s*\\(");
-        if (typeRegExp.indexIn(line) == 0) {
-          error = "Parameter name: " + name + "\n" + "Type <" + typeRegExp.cap(1) + "> is not recognized\n" + error;
-        } else {
-          error = "Parameter name: " + name + "\n" + error;
-        }
-      }
-    }
+  result->_update = parameter.update;
+  if (!result->initFromSchema(parameter)) {
+    delete result;
+    result = nullptr;
+    error = "Parameter name: " + parameter.name + "\n";
   }
   return result;
 }
 
-QStringList AbstractParameter::parseText(const QString & type, const char * text, int & length)
+void AbstractParameter::setWidgetPool(WidgetPool * pool)
 {
-  QStringList result;
-  QString str = text;
-  result << str.left(str.indexOf("=")).trimmed();
-
-  QRegExp re(QString("^[^=]*\\s*=\\s*(_?)%1\\s*(.)").arg(type), Qt::CaseInsensitive);
-  re.indexIn(str);
-  int prefixLength = re.matchedLength();
-
-  if (re.cap(1) == "_") {
-    _update = false;
-  }
+  _widgetPool = pool;
+}
 
-  QString open = re.cap(2);
-  const char * end = 0;
-  if (open == "(") {
-    end = strstr(text + prefixLength, ")");
-  } else if (open == "{") {
-    end = strstr(text + prefixLength, "}");
-  } else if (open == "[") {
-    end = strstr(text + prefixLength, "]");
+void AbstractParameter::recycleWidget(QWidget * widget)
+{
+  if (!widget) {
+    return;
   }
-  QString values = str.mid(prefixLength, -1).left(end - (text + prefixLength)).trimmed();
-  length = 1 + end - text;
-  while (text[length] && (text[length] == ',' || str[length].isSpace())) {
-    ++length;
+  if (_widgetPool) {
+    widget->disconnect(this);
+    _widgetPool->recycle(widget);
+  } else {
+    delete widget;
   }
-  result << values;
-  return result;
 }
 
-bool AbstractParameter::matchType(const QString & type, const char * text) const
+void AbstractParameter::notifyIfRelevant()
 {
-  return QString(text).contains(QRegExp(QString("^[^=]*\\s*=\\s*_?%1\\s*.").arg(type), Qt::CaseInsensitive));
+  if (_update) {
+    emit valueChanged();
+  }
 }
 
-void AbstractParameter::notifyIfRelevant()
+void AbstractParameter::notifyChangingIfRelevant()
 {
   if (_update) {
-    emit valueChanged();
+    emit valueChanging();
   }
 }
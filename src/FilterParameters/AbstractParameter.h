@@ -26,6 +26,8 @@
 #define _GMIC_QT_ABSTRACTPARAMETER_H_
 
 #include <QObject>
+#include "FilterParameters/ParametersSchema.h"
+#include "FilterParameters/WidgetPool.h"
 
 class AbstractParameter : public QObject {
   Q_OBJECT
@@ -41,19 +43,28 @@ public:
   virtual void setValue(const QString & value) = 0;
   virtual void clear();
   virtual void reset() = 0;
-  static AbstractParameter * createFromText(const char * text, int & length, QString & error, QObject * parent = 0);
-  virtual bool initFromText(const char * text, int & textLength) = 0;
+  static AbstractParameter * createFromSchema(const ParametersSchema::Parameter & parameter, QString & error, QObject * parent = 0);
+  virtual bool initFromSchema(const ParametersSchema::Parameter & parameter) = 0;
+  void setWidgetPool(WidgetPool * pool);
 signals:
   void valueChanged();
+  void valueChanging(); // Value is being changed by a slider drag, valueChanged() will follow
 
 protected:
-  QStringList parseText(const QString & type, const char * text, int & length);
-  bool matchType(const QString & type, const char * text) const;
   void notifyIfRelevant();
+  void notifyChangingIfRelevant();
+  template <typename T> T * takeWidget(QWidget * parent);
+  void recycleWidget(QWidget * widget);
   const bool _actualParameter;
 
 private:
   bool _update;
+  WidgetPool * _widgetPool;
 };
 
+template <typename T> T * AbstractParameter::takeWidget(QWidget * parent)
+{
+  return _widgetPool ? _widgetPool->take<T>(parent) : new T(parent);
+}
+
 #endif // _GMIC_QT_ABSTRACTPARAMETER_H_
@@ -87,10 +87,9 @@ void BoolParameter::onCheckBoxChanged(bool on)
   notifyIfRelevant();
 }
 
-bool BoolParameter::initFromText(const char * text, int & textLength)
+bool BoolParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("bool", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  _value = _default = (list[1].startsWith("true") || list[1].startsWith("1"));
+  _name = HtmlTranslator::html2txt(parameter.name);
+  _value = _default = (parameter.values.startsWith("true") || parameter.values.startsWith("1"));
   return true;
 }
@@ -39,7 +39,7 @@ public:
   QString textValue() const override;
   void setValue(const QString & value) override;
   void reset() override;
-  bool initFromText(const char * text, int & textLength) override;
+  bool initFromSchema(const ParametersSchema::Parameter & parameter) override;
 public slots:
   void onCheckBoxChanged(bool);
 
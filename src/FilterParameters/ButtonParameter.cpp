@@ -77,11 +77,10 @@ void ButtonParameter::onPushButtonClicked(bool)
   notifyIfRelevant();
 }
 
-bool ButtonParameter::initFromText(const char * text, int & textLength)
+bool ButtonParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("button", text, textLength);
-  _text = HtmlTranslator::html2txt(list[0]);
-  QString & alignment = list[1];
+  _text = HtmlTranslator::html2txt(parameter.name);
+  const QString & alignment = parameter.values;
   if (alignment.isEmpty()) {
     return true;
   } else {
@@ -43,7 +43,7 @@ public:
   void setValue(const QString &) override;
   void clear() override;
   void reset() override;
-  bool initFromText(const char * text, int & textLength) override;
+  bool initFromSchema(const ParametersSchema::Parameter & parameter) override;
 public slots:
   void onPushButtonClicked(bool);
 
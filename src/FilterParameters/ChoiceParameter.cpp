@@ -36,8 +36,8 @@ ChoiceParameter::ChoiceParameter(QObject * parent) : AbstractParameter(parent, t
 
 ChoiceParameter::~ChoiceParameter()
 {
-  delete _comboBox;
-  delete _label;
+  recycleWidget(_comboBox);
+  recycleWidget(_label);
 }
 
 void ChoiceParameter::addTo(QWidget * widget, int row)
@@ -45,21 +45,24 @@ void ChoiceParameter::addTo(QWidget * widget, int row)
   QGridLayout * grid = dynamic_cast<QGridLayout *>(widget->layout());
   if (!grid)
     return;
-  delete _comboBox;
-  delete _label;
+  recycleWidget(_comboBox);
+  recycleWidget(_label);
 
-  _comboBox = new QComboBox(widget);
+  _comboBox = takeWidget<QComboBox>(widget);
+  _comboBox->clear();
   _comboBox->addItems(_choices);
   _comboBox->setCurrentIndex(_value);
 
-  grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
+  _label = takeWidget<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label, row, 0, 1, 1);
   grid->addWidget(_comboBox, row, 1, 1, 2);
   connect(_comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onComboBoxIndexChanged(int)));
 }
 
 QString ChoiceParameter::textValue() const
 {
-  return QString("%1").arg(_comboBox->currentIndex());
+  return QString("%1").arg(_comboBox ? _comboBox->currentIndex() : _value);
 }
 
 void ChoiceParameter::setValue(const QString & value)
@@ -76,11 +79,10 @@ void ChoiceParameter::reset()
   _value = _default;
 }
 
-bool ChoiceParameter::initFromText(const char * text, int & textLength)
+bool ChoiceParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QStringList list = parseText("choice", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  _choices = list[1].split(QChar(','));
+  _name = HtmlTranslator::html2txt(parameter.name);
+  _choices = parameter.values.split(QChar(','));
   bool ok;
   if (_choices.isEmpty()) {
     return false;
@@ -40,7 +40,7 @@ public:
   QString textValue() const override;
   void setValue(const QString &) override;
   void reset() override;
-  bool initFromText(const char * text, int & textLength) override;
+  bool initFromSchema(const ParametersSchema::Parameter & parameter) override;
 public slots:
   void onComboBoxIndexChanged(int);
 
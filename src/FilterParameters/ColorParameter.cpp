@@ -44,8 +44,8 @@ ColorParameter::ColorParameter(QObject * parent) : AbstractParameter(parent, tru
 
 ColorParameter::~ColorParameter()
 {
-  delete _button;
-  delete _label;
+  recycleWidget(_button);
+  recycleWidget(_label);
   delete _dialog;
 }
 
@@ -54,10 +54,10 @@ void ColorParameter::addTo(QWidget * widget, int row)
   QGridLayout * grid = dynamic_cast<QGridLayout *>(widget->layout());
   if (!grid)
     return;
-  delete _button;
-  delete _label;
+  recycleWidget(_button);
+  recycleWidget(_label);
 
-  _button = new QPushButton(widget);
+  _button = takeWidget<QPushButton>(widget);
   _button->setText("");
 
   QFontMetrics fm(widget->font());
@@ -69,7 +69,9 @@ void ColorParameter::addTo(QWidget * widget, int row)
 
   updateButtonColor();
 
-  grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
+  _label = takeWidget<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label, row, 0, 1, 1);
   grid->addWidget(_button, row, 1, 1, 1);
   connect(_button, SIGNAL(clicked()), this, SLOT(onButtonPressed()));
 }
@@ -107,11 +109,10 @@ void ColorParameter::reset()
   updateButtonColor();
 }
 
-bool ColorParameter::initFromText(const char * text, int & textLength)
+bool ColorParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("color", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  QList<QString> channels = list[1].split(",");
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QList<QString> channels = parameter.values.split(",");
   const int n = channels.size();
   bool okR = true, okG = true, okB = true, okA = true;
   int r = (n > 0) ? channels[0].toInt(&okR) : 0;
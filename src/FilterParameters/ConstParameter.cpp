@@ -60,10 +60,9 @@ void ConstParameter::reset()
   _value = _default;
 }
 
-bool ConstParameter::initFromText(const char * text, int & textLength)
+bool ConstParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QStringList list = parseText("value", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  _value = _default = list[1];
+  _name = HtmlTranslator::html2txt(parameter.name);
+  _value = _default = parameter.values;
   return true;
 }
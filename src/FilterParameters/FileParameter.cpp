@@ -98,26 +98,23 @@ void FileParameter::reset()
   setValue(_default);
 }
 
-bool FileParameter::initFromText(const char * text, int & textLength)
+bool FileParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list;
-  if (matchType("filein", text)) {
-    list = parseText("filein", text, textLength);
+  if (parameter.type == ParametersSchema::FileInType) {
     _dialogMode = InputMode;
-  } else if (matchType("fileout", text)) {
-    list = parseText("fileout", text, textLength);
+  } else if (parameter.type == ParametersSchema::FileOutType) {
     _dialogMode = OutputMode;
   } else {
-    list = parseText("file", text, textLength);
     _dialogMode = InputOutputMode;
   }
-  _name = HtmlTranslator::html2txt(list[0]);
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QString value = parameter.values;
   QRegExp re("^\".*\"$");
-  if (re.exactMatch(list[1])) {
-    list[1].chop(1);
-    list[1].remove(0, 1);
+  if (re.exactMatch(value)) {
+    value.chop(1);
+    value.remove(0, 1);
   }
-  _default = _value = list[1];
+  _default = _value = value;
   return true;
 }
 
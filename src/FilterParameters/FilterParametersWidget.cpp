@@ -44,6 +44,7 @@ FilterParametersWidget::FilterParametersWidget(QWidget * parent) : QWidget(paren
 
 bool FilterParametersWidget::build(const QString & name, const QString & hash, const QString & parameters, const QList<QString> & values)
 {
+  TIMING;
   _filterName = name;
   _filterHash = hash;
   clear();
@@ -51,24 +52,25 @@ bool FilterParametersWidget::build(const QString & name, const QString & hash, c
   QGridLayout * grid = new QGridLayout(this);
   grid->setRowStretch(1, 2);
 
-  QByteArray rawText = parameters.toLatin1();
-  const char * cstr = rawText.constData();
-  int length;
+  const ParametersSchema schema = ParametersSchema::get(hash, parameters);
 
   // Build parameters and count actual ones
   _actualParametersCount = 0;
   QString error;
-  AbstractParameter * parameter;
-  do {
-    parameter = AbstractParameter::createFromText(cstr, length, error, this);
-    if (parameter) {
-      _presetParameters.push_back(parameter);
-      if (parameter->isActualParameter()) {
-        _actualParametersCount += 1;
-      }
+  for (const ParametersSchema::Parameter & description : schema.parameters()) {
+    AbstractParameter * parameter = AbstractParameter::createFromSchema(description, error, this);
+    if (!parameter) {
+      break;
+    }
+    parameter->setWidgetPool(&_widgetPool);
+    _presetParameters.push_back(parameter);
+    if (parameter->isActualParameter()) {
+      _actualParametersCount += 1;
     }
-    cstr += length;
-  } while (parameter && error.isEmpty());
+  }
+  if (error.isEmpty()) {
+    error = schema.error();
+  }
 
   if (!error.isEmpty()) {
     for (AbstractParameter * p : _presetParameters) {
@@ -101,6 +103,7 @@ bool FilterParametersWidget::build(const QString & name, const QString & hash, c
       grid->setRowStretch(row - 1, 0);
     }
     connect(*it, SIGNAL(valueChanged()), this, SLOT(updateValueString()));
+    connect(*it, SIGNAL(valueChanging()), this, SLOT(onParameterValueChanging()));
     ++it;
   }
 
@@ -133,7 +136,66 @@ bool FilterParametersWidget::build(const QString & name, const QString & hash, c
     }
     grid->addWidget(_labelNoParams, 0, 0, 4, 3);
   }
+
+  // Widgets taken from the pool keep their former place in the focus chain:
+  // make the Tab order follow the grid again.
+  QWidget * previous = this;
+  for (int r = 0; r < grid->rowCount(); ++r) {
+    for (int c = 0; c < grid->columnCount(); ++c) {
+      QLayoutItem * item = grid->itemAtPosition(r, c);
+      QWidget * widget = item ? item->widget() : nullptr;
+      if (widget && (widget != previous) && (widget->focusPolicy() & Qt::TabFocus)) {
+        setTabOrder(previous, widget);
+        previous = widget;
+      }
+    }
+  }
   updateValueString(false);
+  TIMING;
+  return error.isEmpty();
+}
+
+bool FilterParametersWidget::buildValueString(const QString & hash, const QString & parameters, const QList<QString> & values, QString & valueString, QString & error)
+{
+  const ParametersSchema schema = ParametersSchema::get(hash, parameters);
+  QVector<AbstractParameter *> presetParameters;
+  int actualParametersCount = 0;
+  error.clear();
+  for (const ParametersSchema::Parameter & description : schema.parameters()) {
+    AbstractParameter * parameter = AbstractParameter::createFromSchema(description, error, nullptr);
+    if (!parameter) {
+      break;
+    }
+    presetParameters.push_back(parameter);
+    if (parameter->isActualParameter()) {
+      actualParametersCount += 1;
+    }
+  }
+  if (error.isEmpty()) {
+    error = schema.error();
+  }
+  valueString.clear();
+  if (error.isEmpty()) {
+    QList<QString>::const_iterator itValue = values.cbegin();
+    bool firstParameter = true;
+    for (AbstractParameter * parameter : presetParameters) {
+      if (!parameter->isActualParameter()) {
+        continue;
+      }
+      if (values.size() == actualParametersCount) {
+        parameter->setValue(*itValue++);
+      }
+      const QString str = parameter->textValue();
+      if (!str.isNull()) {
+        if (!firstParameter) {
+          valueString += ",";
+        }
+        valueString += str;
+        firstParameter = false;
+      }
+    }
+  }
+  qDeleteAll(presetParameters);
   return error.isEmpty();
 }
 
@@ -232,6 +294,12 @@ void FilterParametersWidget::updateValueString(bool notify)
   }
 }
 
+void FilterParametersWidget::onParameterValueChanging()
+{
+  updateValueString(false);
+  emit valueChanging();
+}
+
 void FilterParametersWidget::clear()
 {
   QVector<AbstractParameter *>::iterator it = _presetParameters.begin();
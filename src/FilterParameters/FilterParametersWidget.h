@@ -31,6 +31,7 @@
 #include <QStringList>
 #include <QVector>
 #include <QWidget>
+#include "FilterParameters/WidgetPool.h"
 class AbstractParameter;
 class QLabel;
 
@@ -50,12 +51,21 @@ public:
   int actualParametersCount() const;
   QString filterHash() const;
   void clearButtonParameters() const;
+  /**
+   * @brief Quoted argument string of a filter, as valueString() would give it,
+   *        without creating any widget. The values (unquoted, as saved in the
+   *        parameters cache or in faves) replace the defaults if their count matches.
+   * @return false if the parameters could not be parsed
+   */
+  static bool buildValueString(const QString & hash, const QString & parameters, const QList<QString> & values, QString & valueString, QString & error);
 
 public slots:
   void updateValueString(bool notify = true);
+  void onParameterValueChanging();
 
 signals:
   void valueChanged();
+  void valueChanging();
 
 protected:
   void clear();
@@ -66,6 +76,7 @@ protected:
   QWidget * _paddingWidget;
   QString _filterName;
   QString _filterHash;
+  WidgetPool _widgetPool;
 };
 
 #endif // _GMIC_QT_FILTERPARAMSWIDGET_H_
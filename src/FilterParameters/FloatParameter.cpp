@@ -45,9 +45,9 @@ FloatParameter::FloatParameter(QObject * parent) : AbstractParameter(parent, tru
 
 FloatParameter::~FloatParameter()
 {
-  delete _spinBox;
-  delete _slider;
-  delete _label;
+  recycleWidget(_spinBox);
+  recycleWidget(_slider);
+  recycleWidget(_label);
 }
 
 void FloatParameter::addTo(QWidget * widget, int row)
@@ -55,10 +55,11 @@ void FloatParameter::addTo(QWidget * widget, int row)
   QGridLayout * grid = dynamic_cast<QGridLayout *>(widget->layout());
   if (!grid)
     return;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal, widget);
+  recycleWidget(_spinBox);
+  recycleWidget(_slider);
+  recycleWidget(_label);
+  _slider = takeWidget<QSlider>(widget);
+  _slider->setOrientation(Qt::Horizontal);
   _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
   _slider->setRange(0, 1000);
   _slider->setValue(static_cast<int>(1000 * (_value - _min) / (_max - _min)));
@@ -68,12 +69,14 @@ void FloatParameter::addTo(QWidget * widget, int row)
     p.setColor(QPalette::Highlight, QColor(130, 130, 130));
     _slider->setPalette(p);
   }
-  _spinBox = new QDoubleSpinBox(widget);
+  _spinBox = takeWidget<QDoubleSpinBox>(widget);
   _spinBox->setRange(_min, _max);
   _spinBox->setValue(_value);
   _spinBox->setDecimals(2);
   _spinBox->setSingleStep((_max - _min) / 100.0);
-  grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
+  _label = takeWidget<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label, row, 0, 1, 1);
   grid->addWidget(_slider, row, 1, 1, 1);
   grid->addWidget(_spinBox, row, 2, 1, 1);
   connectSliderSpinBox();
@@ -83,7 +86,7 @@ QString FloatParameter::textValue() const
 {
   QLocale currentLocale;
   QLocale::setDefault(QLocale::c());
-  QString value = QString("%1").arg(_spinBox->value());
+  QString value = QString("%1").arg(_spinBox ? _spinBox->value() : _value);
   QLocale::setDefault(currentLocale);
   return value;
 }
@@ -108,12 +111,10 @@ void FloatParameter::reset()
   connectSliderSpinBox();
 }
 
-bool FloatParameter::initFromText(const char * text, int & textLength)
+bool FloatParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  textLength = 0;
-  QList<QString> list = parseText("float", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  QList<QString> values = list[1].split(QChar(','));
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QList<QString> values = parameter.values.split(QChar(','));
   if (values.size() != 3) {
     return false;
   }
@@ -158,6 +159,19 @@ void FloatParameter::onSpinBoxChanged(double x)
     killTimer(_timerId);
   }
   _timerId = startTimer(UPDATE_DELAY);
+  if (_slider->isSliderDown()) {
+    notifyChangingIfRelevant();
+  }
+}
+
+void FloatParameter::onSliderReleased()
+{
+  // Final value is known: no need to wait for the timer
+  if (_timerId) {
+    killTimer(_timerId);
+    _timerId = 0;
+    notifyIfRelevant();
+  }
 }
 
 void FloatParameter::connectSliderSpinBox()
@@ -167,6 +181,7 @@ void FloatParameter::connectSliderSpinBox()
   }
   connect(_slider, SIGNAL(sliderMoved(int)), this, SLOT(onSliderMoved(int)));
   connect(_slider, SIGNAL(valueChanged(int)), this, SLOT(onSliderValueChanged(int)));
+  connect(_slider, SIGNAL(sliderReleased()), this, SLOT(onSliderReleased()));
   connect(_spinBox, SIGNAL(valueChanged(double)), this, SLOT(onSpinBoxChanged(double)));
   _connected = true;
 }
@@ -94,20 +94,20 @@ void FolderParameter::reset()
   setValue(_default);
 }
 
-bool FolderParameter::initFromText(const char * text, int & textLength)
+bool FolderParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("folder", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QString value = parameter.values;
   QRegExp re("^\".*\"$");
-  if (re.exactMatch(list[1])) {
-    list[1].chop(1);
-    list[1].remove(0, 1);
+  if (re.exactMatch(value)) {
+    value.chop(1);
+    value.remove(0, 1);
   }
-  if (list[1].isEmpty()) {
+  if (value.isEmpty()) {
     _default.clear();
     _value = DialogSettings::FolderParameterDefaultValue;
   } else {
-    _default = _value = list[1];
+    _default = _value = value;
   }
   return true;
 }
@@ -40,7 +40,7 @@ public:
   QString unquotedTextValue() const override;
   void setValue(const QString & value) override;
   void reset() override;
-  bool initFromText(const char * text, int & textLength) override;
+  bool initFromSchema(const ParametersSchema::Parameter & parameter) override;
 public slots:
   void onButtonPressed();
 
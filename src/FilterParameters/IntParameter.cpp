@@ -42,9 +42,9 @@ IntParameter::IntParameter(QObject * parent) : AbstractParameter(parent, true),
 
 IntParameter::~IntParameter()
 {
-  delete _spinBox;
-  delete _slider;
-  delete _label;
+  recycleWidget(_spinBox);
+  recycleWidget(_slider);
+  recycleWidget(_label);
 }
 
 void IntParameter::addTo(QWidget * widget, int row)
@@ -52,14 +52,15 @@ void IntParameter::addTo(QWidget * widget, int row)
   QGridLayout * grid = dynamic_cast<QGridLayout *>(widget->layout());
   if (!grid)
     return;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal, widget);
+  recycleWidget(_spinBox);
+  recycleWidget(_slider);
+  recycleWidget(_label);
+  _slider = takeWidget<QSlider>(widget);
+  _slider->setOrientation(Qt::Horizontal);
   _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
   _slider->setRange(_min, _max);
   _slider->setValue(_value);
-  _spinBox = new QSpinBox(widget);
+  _spinBox = takeWidget<QSpinBox>(widget);
   _spinBox->setRange(_min, _max);
   _spinBox->setValue(_value);
   if (DialogSettings::darkThemeEnabled()) {
@@ -68,7 +69,9 @@ void IntParameter::addTo(QWidget * widget, int row)
     p.setColor(QPalette::Highlight, QColor(130, 130, 130));
     _slider->setPalette(p);
   }
-  grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
+  _label = takeWidget<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label, row, 0, 1, 1);
   grid->addWidget(_slider, row, 1, 1, 1);
   grid->addWidget(_spinBox, row, 2, 1, 1);
   connectSliderSpinBox();
@@ -76,7 +79,7 @@ void IntParameter::addTo(QWidget * widget, int row)
 
 QString IntParameter::textValue() const
 {
-  return _spinBox->text();
+  return _spinBox ? _spinBox->text() : QString::number(_value);
 }
 
 void IntParameter::setValue(const QString & value)
@@ -99,11 +102,10 @@ void IntParameter::reset()
   connectSliderSpinBox();
 }
 
-bool IntParameter::initFromText(const char * text, int & textLength)
+bool IntParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("int", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  QList<QString> values = list[1].split(QChar(','));
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QList<QString> values = parameter.values.split(QChar(','));
   if (values.size() != 3) {
     return false;
   }
@@ -144,6 +146,19 @@ void IntParameter::onSpinBoxChanged(int i)
     killTimer(_timerId);
   }
   _timerId = startTimer(UPDATE_DELAY);
+  if (_slider->isSliderDown()) {
+    notifyChangingIfRelevant();
+  }
+}
+
+void IntParameter::onSliderReleased()
+{
+  // Final value is known: no need to wait for the timer
+  if (_timerId) {
+    killTimer(_timerId);
+    _timerId = 0;
+    notifyIfRelevant();
+  }
 }
 
 void IntParameter::connectSliderSpinBox()
@@ -153,6 +168,7 @@ void IntParameter::connectSliderSpinBox()
   }
   connect(_slider, SIGNAL(sliderMoved(int)), this, SLOT(onSliderMoved(int)));
   connect(_slider, SIGNAL(valueChanged(int)), this, SLOT(onSliderValueChanged(int)));
+  connect(_slider, SIGNAL(sliderReleased()), this, SLOT(onSliderReleased()));
   connect(_spinBox, SIGNAL(valueChanged(int)), this, SLOT(onSpinBoxChanged(int)));
   _connected = true;
 }
@@ -40,7 +40,7 @@ public:
   QString textValue() const override;
   void setValue(const QString & value) override;
   void reset() override;
-  bool initFromText(const char * text, int & textLength) override;
+  bool initFromSchema(const ParametersSchema::Parameter & parameter) override;
 
 protected:
   void timerEvent(QTimerEvent *) override;
@@ -48,6 +48,7 @@ public slots:
   void onSliderMoved(int);
   void onSliderValueChanged(int value);
   void onSpinBoxChanged(int);
+  void onSliderReleased();
 
 private:
   void connectSliderSpinBox();
@@ -68,10 +68,9 @@ void LinkParameter::reset()
 {
 }
 
-bool LinkParameter::initFromText(const char * text, int & textLength)
+bool LinkParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("link", text, textLength);
-  QList<QString> values = list[1].split(QChar(','));
+  QList<QString> values = parameter.values.split(QChar(','));
 
   if (values.size() == 3) {
     bool ok;
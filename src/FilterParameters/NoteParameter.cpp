@@ -68,10 +68,9 @@ void NoteParameter::reset()
 {
 }
 
-bool NoteParameter::initFromText(const char * text, int & textLength)
+bool NoteParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QList<QString> list = parseText("note", text, textLength);
-  _text = list[1].trimmed().remove(QRegExp("^\"")).remove(QRegExp("\"$")).replace(QString("\\\""), "\"");
+  _text = parameter.values.trimmed().remove(QRegExp("^\"")).remove(QRegExp("\"$")).replace(QString("\\\""), "\"");
   _text.replace(QString("\\n"), "<br/>");
 
   if (DialogSettings::darkThemeEnabled()) {
@@ -0,0 +1,179 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParametersSchema.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterParameters/ParametersSchema.h"
+#include <QByteArray>
+#include <cctype>
+#include <cstring>
+#include "Common.h"
+
+QCache<QString, ParametersSchema> ParametersSchema::_cache(ParametersSchema::CacheSize);
+
+namespace
+{
+struct TypeKeyword {
+  const char * keyword;
+  ParametersSchema::ParameterType type;
+};
+
+// Same order as the former regular expressions: first prefix match wins
+const TypeKeyword TypeKeywords[] = {{"int", ParametersSchema::IntType},       {"float", ParametersSchema::FloatType},   {"bool", ParametersSchema::BoolType},
+                                    {"choice", ParametersSchema::ChoiceType}, {"color", ParametersSchema::ColorType},   {"separator", ParametersSchema::SeparatorType},
+                                    {"note", ParametersSchema::NoteType},     {"filein", ParametersSchema::FileInType}, {"fileout", ParametersSchema::FileOutType},
+                                    {"file", ParametersSchema::FileType},     {"folder", ParametersSchema::FolderType}, {"text", ParametersSchema::TextType},
+                                    {"link", ParametersSchema::LinkType},     {"value", ParametersSchema::ValueType},   {"button", ParametersSchema::ButtonType}};
+
+inline bool isSpace(char c)
+{
+  return std::isspace(static_cast<unsigned char>(c));
+}
+
+bool startsWithNoCase(const char * text, const char * prefix)
+{
+  while (*prefix) {
+    if (std::tolower(static_cast<unsigned char>(*text)) != *prefix) {
+      return false;
+    }
+    ++text;
+    ++prefix;
+  }
+  return true;
+}
+
+const char * skipSpaces(const char * text)
+{
+  while (*text && isSpace(*text)) {
+    ++text;
+  }
+  return text;
+}
+}
+
+ParametersSchema::ParametersSchema()
+{
+}
+
+ParametersSchema ParametersSchema::compile(const QString & parameters)
+{
+  ParametersSchema schema;
+  schema._text = parameters;
+  QByteArray rawText = parameters.toLatin1();
+  const char * text = rawText.constData();
+  while (*text) {
+    // name = type(values),
+    const char * equal = std::strchr(text, '=');
+    if (!equal) {
+      break;
+    }
+    Parameter parameter;
+    const QString rawName = QString::fromUtf8(text, static_cast<int>(equal - text));
+    parameter.name = rawName.trimmed();
+    const char * position = skipSpaces(equal + 1);
+    parameter.update = (*position != '_');
+    if (!parameter.update) {
+      ++position;
+    }
+    const TypeKeyword * typeKeyword = nullptr;
+    for (const TypeKeyword & keyword : TypeKeywords) {
+      if (startsWithNoCase(position, keyword.keyword)) {
+        typeKeyword = &keyword;
+        break;
+      }
+    }
+    if (!typeKeyword) {
+      // Type is the word before the opening parenthesis, if any
+      const char * typeEnd = position;
+      while (*typeEnd && *typeEnd != '(' && *typeEnd != ' ') {
+        ++typeEnd;
+      }
+      schema._error = "Parameter name: " + rawName + "\n";
+      if (*skipSpaces(typeEnd) == '(') {
+        schema._error += "Type <" + QString::fromUtf8(position, static_cast<int>(typeEnd - position)) + "> is not recognized\n";
+      }
+      break;
+    }
+    parameter.type = typeKeyword->type;
+    position = skipSpaces(position + std::strlen(typeKeyword->keyword));
+    const char * close = nullptr;
+    if (*position == '(') {
+      close = std::strchr(position, ')');
+    } else if (*position == '{') {
+      close = std::strchr(position, '}');
+    } else if (*position == '[') {
+      close = std::strchr(position, ']');
+    }
+    if (!close) {
+      schema._error = "Parameter name: " + rawName + "\n";
+      break;
+    }
+    parameter.values = QString::fromUtf8(position + 1, static_cast<int>(close - position - 1)).trimmed();
+    schema._parameters.push_back(parameter);
+    text = close + 1;
+    while (*text && (*text == ',' || isSpace(*text))) {
+      ++text;
+    }
+  }
+  return schema;
+}
+
+ParametersSchema ParametersSchema::get(const QString & hash, const QString & parameters)
+{
+  ParametersSchema * schema = _cache.object(hash);
+  if (!schema || schema->_text != parameters) {
+    schema = new ParametersSchema(compile(parameters));
+    _cache.insert(hash, schema);
+  }
+  return *schema;
+}
+
+void ParametersSchema::clearCache()
+{
+  _cache.clear();
+}
+
+const QVector<ParametersSchema::Parameter> & ParametersSchema::parameters() const
+{
+  return _parameters;
+}
+
+int ParametersSchema::actualParametersCount() const
+{
+  int count = 0;
+  for (const Parameter & parameter : _parameters) {
+    if (isActualParameter(parameter.type)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+const QString & ParametersSchema::error() const
+{
+  return _error;
+}
+
+bool ParametersSchema::isActualParameter(ParameterType type)
+{
+  return (type != SeparatorType) && (type != NoteType) && (type != LinkType);
+}
@@ -0,0 +1,91 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParametersSchema.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_PARAMETERSSCHEMA_H_
+#define _GMIC_QT_PARAMETERSSCHEMA_H_
+
+#include <QCache>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Parsed description of the parameters of a filter, independent of
+ *        any widget. Schemas of the recently used filters are cached, so that
+ *        FilterParametersWidget::build() only has to instantiate parameters.
+ */
+class ParametersSchema {
+public:
+  enum ParameterType
+  {
+    IntType,
+    FloatType,
+    BoolType,
+    ChoiceType,
+    ColorType,
+    SeparatorType,
+    NoteType,
+    FileType,
+    FileInType,
+    FileOutType,
+    FolderType,
+    TextType,
+    LinkType,
+    ValueType,
+    ButtonType
+  };
+
+  struct Parameter {
+    ParameterType type;
+    QString name;   // As written in the filter definition (may contain HTML)
+    QString values; // Text between the brackets
+    bool update;    // False if the type is prefixed by '_'
+  };
+
+  ParametersSchema();
+  static ParametersSchema compile(const QString & parameters);
+  /**
+   * @brief Cached schema of a filter (copies are cheap, data is shared)
+   */
+  static ParametersSchema get(const QString & hash, const QString & parameters);
+  /**
+   * @brief Empty the cache (e.g. when the filters catalogue is replaced)
+   */
+  static void clearCache();
+  const QVector<Parameter> & parameters() const;
+  int actualParametersCount() const;
+  /**
+   * @brief Error found after the last parameter of the schema (empty if none)
+   */
+  const QString & error() const;
+  static bool isActualParameter(ParameterType type);
+
+private:
+  QVector<Parameter> _parameters;
+  QString _error;
+  QString _text;
+  static const int CacheSize = 256; // Filters
+  static QCache<QString, ParametersSchema> _cache;
+};
+
+#endif // _GMIC_QT_PARAMETERSSCHEMA_H_
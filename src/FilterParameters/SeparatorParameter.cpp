@@ -67,9 +67,8 @@ void SeparatorParameter::reset()
 {
 }
 
-bool SeparatorParameter::initFromText(const char * text, int & textLength)
+bool SeparatorParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QStringList list = parseText("separator", text, textLength);
-  unused(list);
+  unused(parameter);
   return true;
 }
@@ -77,13 +77,16 @@ void TextParameter::addTo(QWidget * widget, int row)
 
 QString TextParameter::textValue() const
 {
-  QString text = _multiline ? _textEdit->text() : _lineEdit->text();
+  QString text = unquotedTextValue();
   text.replace(QChar('"'), QString("\\\""));
   return QString("\"%1\"").arg(text);
 }
 
 QString TextParameter::unquotedTextValue() const
 {
+  if (_multiline ? !_textEdit : !_lineEdit) {
+    return _value; // No widget (see FilterParametersWidget::buildValueString())
+  }
   return _multiline ? _textEdit->text() : _lineEdit->text();
 }
 
@@ -107,11 +110,10 @@ void TextParameter::reset()
   _value = _default;
 }
 
-bool TextParameter::initFromText(const char * text, int & textLength)
+bool TextParameter::initFromSchema(const ParametersSchema::Parameter & parameter)
 {
-  QStringList list = parseText("text", text, textLength);
-  _name = HtmlTranslator::html2txt(list[0]);
-  QString value = list[1];
+  _name = HtmlTranslator::html2txt(parameter.name);
+  QString value = parameter.values;
   _multiline = false;
   QRegExp re("^\\s*(0|1)\\s*,");
   if (value.contains(re) && re.matchedLength() > 0) {
@@ -0,0 +1,53 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file WidgetPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterParameters/WidgetPool.h"
+
+WidgetPool::WidgetPool()
+{
+}
+
+void WidgetPool::recycle(QWidget * widget)
+{
+  if (!widget) {
+    return;
+  }
+  widget->hide();
+  _widgets[widget->metaObject()].push_back(widget);
+}
+
+QWidget * WidgetPool::takeWidget(const QMetaObject * metaObject, QWidget * parent)
+{
+  QHash<const QMetaObject *, QVector<QWidget *>>::iterator it = _widgets.find(metaObject);
+  if (it == _widgets.end() || it->isEmpty()) {
+    return nullptr;
+  }
+  QWidget * widget = it->back();
+  it->pop_back();
+  if (widget->parentWidget() != parent) {
+    widget->setParent(parent);
+  }
+  widget->show();
+  return widget;
+}
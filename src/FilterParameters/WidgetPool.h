@@ -0,0 +1,56 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file WidgetPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_WIDGETPOOL_H_
+#define _GMIC_QT_WIDGETPOOL_H_
+
+#include <QHash>
+#include <QVector>
+#include <QWidget>
+
+/**
+ * @brief Hidden widgets kept aside, per class, when the parameters of a filter
+ *        are destroyed, so that the parameters of the next filter can reuse
+ *        them instead of allocating new ones.
+ *
+ *        Pooled widgets remain children of their parent widget, which owns them.
+ */
+class WidgetPool {
+public:
+  WidgetPool();
+  template <typename T> T * take(QWidget * parent);
+  void recycle(QWidget * widget);
+
+private:
+  QWidget * takeWidget(const QMetaObject * metaObject, QWidget * parent);
+  QHash<const QMetaObject *, QVector<QWidget *>> _widgets;
+};
+
+template <typename T> T * WidgetPool::take(QWidget * parent)
+{
+  QWidget * widget = takeWidget(&T::staticMetaObject, parent);
+  return widget ? static_cast<T *>(widget) : new T(parent);
+}
+
+#endif // _GMIC_QT_WIDGETPOOL_H_
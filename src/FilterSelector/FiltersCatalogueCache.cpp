@@ -0,0 +1,132 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersCatalogueCache.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterSelector/FiltersCatalogueCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include "Common.h"
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "Globals.h"
+#include "Utils.h"
+#include "gmic_qt.h"
+
+const quint32 FiltersCatalogueCache::Magic = 0x676D6663; // "gmfc"
+const qint32 FiltersCatalogueCache::Version = 2;
+
+bool FiltersCatalogueCache::read(FiltersModel & model, const QByteArray & stdlibArray)
+{
+  QFile file(QString("%1%2").arg(GmicQt::path_rc(false), FILTERS_CATALOGUE_CACHE_FILENAME));
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  quint32 magic;
+  qint32 version;
+  QByteArray fileKey;
+  stream >> magic >> version;
+  if ((stream.status() != QDataStream::Ok) || (magic != Magic) || (version != Version)) {
+    return false;
+  }
+  stream >> fileKey;
+  if (fileKey != key(stdlibArray)) {
+    return false;
+  }
+  qint32 count;
+  stream >> count;
+  if ((stream.status() != QDataStream::Ok) || (count < 0)) {
+    return false;
+  }
+  model.clear();
+  QString name;
+  QString plainText;
+  QList<QString> path;
+  QString command;
+  QString previewCommand;
+  QString parameters;
+  float previewFactor;
+  bool accurateIfZoomed;
+  bool tileSafe;
+  bool warning;
+  QString hash;
+  while (count--) {
+    stream >> name >> plainText >> path >> command >> previewCommand >> parameters;
+    stream >> previewFactor >> accurateIfZoomed >> tileSafe >> warning >> hash;
+    if (stream.status() != QDataStream::Ok) {
+      qWarning() << "[gmic-qt] Error: reading" << file.fileName();
+      model.clear();
+      return false;
+    }
+    FiltersModel::Filter filter;
+    filter.setName(name, plainText);
+    filter.setCommand(command);
+    filter.setPreviewCommand(previewCommand);
+    filter.setPreviewFactor(previewFactor);
+    filter.setAccurateIfZoomed(accurateIfZoomed);
+    filter.setTileSafe(tileSafe);
+    filter.setParameters(parameters);
+    filter.setPath(path);
+    filter.setWarningFlag(warning);
+    filter.setHash(hash);
+    model.addFilter(filter);
+  }
+  return true;
+}
+
+void FiltersCatalogueCache::write(const FiltersModel & model, const QByteArray & stdlibArray)
+{
+  QString filename = QString("%1%2").arg(GmicQt::path_rc(true), FILTERS_CATALOGUE_CACHE_FILENAME);
+  // QSaveFile atomically replaces the previous cache, which is kept intact on failure
+  QSaveFile file(filename);
+  if (!file.open(QFile::WriteOnly)) {
+    qWarning() << "[gmic-qt] Error: Cannot write" << filename;
+    return;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream << Magic << Version << key(stdlibArray) << static_cast<qint32>(model.filterCount());
+  for (size_t index = 0; index < model.filterCount(); ++index) {
+    const FiltersModel::Filter & filter = model.getFilter(index);
+    stream << filter.name() << filter.plainText() << filter.path() << filter.command() << filter.previewCommand() << filter.parameters();
+    stream << filter.previewFactor() << filter.isAccurateIfZoomed() << filter.isTileSafe() << filter.isWarning() << filter.hash();
+  }
+  if ((stream.status() != QDataStream::Ok) || !file.commit()) {
+    qWarning() << "[gmic-qt] Error: Cannot write" << filename;
+  }
+}
+
+QByteArray FiltersCatalogueCache::key(const QByteArray & stdlibArray)
+{
+  // Parsed filters depend on the stdlib, on the language of the filter names and on the parser itself
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(stdlibArray);
+  hash.addData(FiltersModelReader::filtersLanguage(stdlibArray).toUtf8());
+  hash.addData(GmicQt::gmicVersionString().toUtf8());
+  hash.addData(QByteArray::number(FiltersModelReader::ParserVersion));
+  return hash.result();
+}
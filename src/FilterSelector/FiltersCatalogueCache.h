@@ -0,0 +1,50 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersCatalogueCache.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSCATALOGUECACHE_H_
+#define _GMIC_QT_FILTERSCATALOGUECACHE_H_
+
+#include <QByteArray>
+#include <QString>
+
+class FiltersModel;
+
+/**
+ * @brief On-disk cache of the filters parsed from the stdlib, so that
+ *        FiltersModelReader::parseFiltersDefinitions() is only needed when
+ *        the stdlib (or the language of the filters) changes.
+ */
+class FiltersCatalogueCache {
+public:
+  static bool read(FiltersModel & model, const QByteArray & stdlibArray);
+  static void write(const FiltersModel & model, const QByteArray & stdlibArray);
+
+private:
+  FiltersCatalogueCache() = delete;
+  static QByteArray key(const QByteArray & stdlibArray);
+  static const quint32 Magic;
+  static const qint32 Version;
+};
+
+#endif // _GMIC_QT_FILTERSCATALOGUECACHE_H_
@@ -0,0 +1,66 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersCatalogueThread.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterSelector/FiltersCatalogueThread.h"
+#include "Common.h"
+#include "FilterSelector/FiltersCatalogueCache.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "Updater.h"
+
+FiltersCatalogueThread::FiltersCatalogueThread(QObject * parent) : QThread(parent)
+{
+}
+
+FiltersCatalogueThread::~FiltersCatalogueThread()
+{
+  wait();
+}
+
+void FiltersCatalogueThread::run()
+{
+  TIMING;
+  _stdlib = Updater::getInstance()->buildFullStdlib();
+  _filtersModel.clear();
+  if (FiltersCatalogueCache::read(_filtersModel, _stdlib)) {
+    TIMING; // Warm start
+    return;
+  }
+  FiltersModelReader filterModelReader(_filtersModel);
+  filterModelReader.parseFiltersDefinitions(_stdlib);
+  TIMING; // Cold start
+  FiltersCatalogueCache::write(_filtersModel, _stdlib);
+}
+
+QByteArray FiltersCatalogueThread::takeStdlib()
+{
+  QByteArray result;
+  result.swap(_stdlib);
+  return result;
+}
+
+void FiltersCatalogueThread::takeFiltersModel(FiltersModel & model)
+{
+  model.swap(_filtersModel);
+  _filtersModel.clear();
+}
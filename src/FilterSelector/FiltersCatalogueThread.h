@@ -0,0 +1,52 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersCatalogueThread.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSCATALOGUETHREAD_H_
+#define _GMIC_QT_FILTERSCATALOGUETHREAD_H_
+
+#include <QByteArray>
+#include <QThread>
+#include "FilterSelector/FiltersModel.h"
+
+/**
+ * @brief Assembles the full stdlib and builds the filters model from it,
+ *        away from the GUI thread. Once finished, the results are taken
+ *        by the GUI thread with takeStdlib() and takeFiltersModel().
+ */
+class FiltersCatalogueThread : public QThread {
+  Q_OBJECT
+
+public:
+  FiltersCatalogueThread(QObject * parent);
+  ~FiltersCatalogueThread();
+  void run();
+  QByteArray takeStdlib();
+  void takeFiltersModel(FiltersModel & model);
+
+private:
+  QByteArray _stdlib;
+  FiltersModel _filtersModel;
+};
+
+#endif // _GMIC_QT_FILTERSCATALOGUETHREAD_H_
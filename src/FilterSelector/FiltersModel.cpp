@@ -43,6 +43,13 @@ FiltersModel::~FiltersModel()
 void FiltersModel::clear()
 {
   _filters.clear();
+  _hash2filterIndex.clear();
+}
+
+void FiltersModel::swap(FiltersModel & other)
+{
+  _filters.swap(other._filters);
+  _hash2filterIndex.swap(other._hash2filterIndex);
 }
 
 void FiltersModel::addFilter(const FiltersModel::Filter & filter)
@@ -108,6 +115,7 @@ FiltersModel::Filter::Filter()
 {
   _previewFactor = GmicQt::PreviewFactorAny;
   _isAccurateIfZoomed = false;
+  _isTileSafe = false;
   _isWarning = false;
 }
 
@@ -118,6 +126,13 @@ FiltersModel::Filter & FiltersModel::Filter::setName(QString name)
   return *this;
 }
 
+FiltersModel::Filter & FiltersModel::Filter::setName(QString name, QString plainText)
+{
+  _name = name;
+  _plainText = plainText;
+  return *this;
+}
+
 FiltersModel::Filter & FiltersModel::Filter::setCommand(QString command)
 {
   _command = command;
@@ -148,6 +163,12 @@ FiltersModel::Filter & FiltersModel::Filter::setAccurateIfZoomed(bool accurate)
   return *this;
 }
 
+FiltersModel::Filter & FiltersModel::Filter::setTileSafe(bool tileSafe)
+{
+  _isTileSafe = tileSafe;
+  return *this;
+}
+
 FiltersModel::Filter & FiltersModel::Filter::setPath(const QList<QString> & path)
 {
   _path = path;
@@ -174,6 +195,12 @@ FiltersModel::Filter & FiltersModel::Filter::build()
   return *this;
 }
 
+FiltersModel::Filter & FiltersModel::Filter::setHash(QString hash)
+{
+  _hash = hash;
+  return *this;
+}
+
 QString FiltersModel::Filter::name() const
 {
   return _name;
@@ -219,6 +246,11 @@ bool FiltersModel::Filter::isAccurateIfZoomed() const
   return _isAccurateIfZoomed;
 }
 
+bool FiltersModel::Filter::isTileSafe() const
+{
+  return _isTileSafe;
+}
+
 bool FiltersModel::Filter::isWarning() const
 {
   return _isWarning;
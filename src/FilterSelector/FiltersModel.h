@@ -36,14 +36,17 @@ public:
   public:
     Filter();
     Filter & setName(QString name);
+    Filter & setName(QString name, QString plainText);
     Filter & setCommand(QString command);
     Filter & setPreviewCommand(QString previewCommand);
     Filter & setParameters(QString parameters);
     Filter & setPreviewFactor(float factor);
     Filter & setAccurateIfZoomed(bool accurate);
+    Filter & setTileSafe(bool tileSafe);
     Filter & setPath(const QList<QString> & path);
     Filter & setWarningFlag(bool flag);
     Filter & build();
+    Filter & setHash(QString hash);
 
     QString name() const;
     QString plainText() const;
@@ -54,6 +57,7 @@ public:
     QString parameters() const;
     float previewFactor() const;
     bool isAccurateIfZoomed() const;
+    bool isTileSafe() const;
     bool isWarning() const;
 
     bool matchKeywords(const QList<QString> & keywords) const;
@@ -67,6 +71,7 @@ public:
     QString _parameters;
     float _previewFactor;
     bool _isAccurateIfZoomed;
+    bool _isTileSafe;
     QString _hash;
     bool _isWarning;
   };
@@ -76,6 +81,7 @@ public:
 
 public:
   void clear();
+  void swap(FiltersModel & other);
   void addFilter(const Filter & filter);
   void flush();
   size_t filterCount() const;
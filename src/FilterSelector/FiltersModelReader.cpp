@@ -23,30 +23,161 @@
  *
  */
 #include "FilterSelector/FiltersModelReader.h"
-#include <QBuffer>
 #include <QDebug>
 #include <QFileInfo>
 #include <QList>
 #include <QLocale>
-#include <QRegularExpression>
 #include <QSettings>
 #include <QString>
+#include <cstring>
 #include "Common.h"
 #include "FilterSelector/FiltersModel.h"
 #include "Globals.h"
 #include "gmic_qt.h"
 #include "gmic.h"
 
-FiltersModelReader::FiltersModelReader(FiltersModel & model) : _model(model)
+namespace
 {
+/*
+ * A line of the stdlib, not copied: [begin, end[ (ends after the '\n', if any)
+ */
+struct Line {
+  const char * begin;
+  const char * end;
+  bool isEmpty() const
+  {
+    return begin == end;
+  }
+  int size() const
+  {
+    return static_cast<int>(end - begin);
+  }
+  bool startsWith(const char * str, int length) const
+  {
+    return (size() >= length) && !std::memcmp(begin, str, length);
+  }
+  bool startsWith(const char * str) const
+  {
+    return startsWith(str, static_cast<int>(std::strlen(str)));
+  }
+  bool startsWith(const QByteArray & str) const
+  {
+    return startsWith(str.constData(), str.size());
+  }
+  const char * find(char c) const
+  {
+    const void * p = std::memchr(begin, c, end - begin);
+    return p ? static_cast<const char *>(p) : nullptr;
+  }
+  Line trimmed() const
+  {
+    Line result = *this;
+    while (result.begin < result.end && isSpace(*result.begin)) {
+      ++result.begin;
+    }
+    while (result.end > result.begin && isSpace(result.end[-1])) {
+      --result.end;
+    }
+    return result;
+  }
+  QString toString() const
+  {
+    return QString::fromUtf8(begin, size());
+  }
+  static bool isSpace(char c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+};
+
+Line nextLine(const char * position, const char * dataEnd)
+{
+  const void * newline = std::memchr(position, '\n', dataEnd - position);
+  return Line{position, newline ? static_cast<const char *>(newline) + 1 : dataEnd};
 }
 
-void FiltersModelReader::parseFiltersDefinitions(QByteArray & stdlibArray)
+inline bool isTagLetter(char c)
 {
-  QBuffer stdlib(&stdlibArray);
-  stdlib.open(QBuffer::ReadOnly);
-  QList<QString> filterPath;
+  return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
 
+// Length of "^..gui[_a-zA-Z]{0,3}[ ]", -1 if no match
+int guiPrefixLength(const Line & line)
+{
+  if (line.size() < 6 || std::memcmp(line.begin + 2, "gui", 3)) {
+    return -1;
+  }
+  const char * p = line.begin + 5;
+  while (p < line.end && p < line.begin + 8 && isTagLetter(*p)) {
+    ++p;
+  }
+  return (p < line.end && *p == ' ') ? static_cast<int>(p + 1 - line.begin) : -1;
+}
+
+// Text following "^..<tag>[ ]", nullptr if no match
+const char * afterGuiTag(const Line & line, const char * tag, int tagLength)
+{
+  if ((line.size() < 3 + tagLength) || std::memcmp(line.begin + 2, tag, tagLength) || (line.begin[2 + tagLength] != ' ')) {
+    return nullptr;
+  }
+  return line.begin + 3 + tagLength;
+}
+
+// "^..gui[ ][^:]+$" or "^..gui_xx[ ][^:]+$"
+bool isFolderLine(const Line & line, const QByteArray & languageTag)
+{
+  const char * text = afterGuiTag(line, "gui", 3);
+  if (!text) {
+    text = afterGuiTag(line, languageTag.constData(), languageTag.size());
+  }
+  return text && (text < line.end) && !std::memchr(text, ':', line.end - text);
+}
+
+// "^..gui[ ][^:]+[ ]*:.*" or "^..gui_xx[ ][^:]+[ ]*:.*"
+bool isFilterLine(const Line & line, const QByteArray & languageTag)
+{
+  const char * text = afterGuiTag(line, "gui", 3);
+  if (!text) {
+    text = afterGuiTag(line, languageTag.constData(), languageTag.size());
+  }
+  if (!text) {
+    return false;
+  }
+  const void * colon = std::memchr(text, ':', line.end - text);
+  return colon && (colon > static_cast<const void *>(text));
+}
+
+// Line without "^..gui[_a-zA-Z]{0,3}[ ]*:[ ]*"
+QByteArray parameterText(const Line & line)
+{
+  const char * p = line.begin + 5;
+  if (line.size() >= 5 && !std::memcmp(line.begin + 2, "gui", 3)) {
+    while (p < line.end && p < line.begin + 8 && isTagLetter(*p)) {
+      ++p;
+    }
+    while (p < line.end && *p == ' ') {
+      ++p;
+    }
+    if (p < line.end && *p == ':') {
+      ++p;
+      while (p < line.end && *p == ' ') {
+        ++p;
+      }
+      return QByteArray(p, static_cast<int>(line.end - p));
+    }
+  }
+  return QByteArray(line.begin, line.size());
+}
+}
+
+const int FiltersModelReader::ParserVersion = 2; // 2: single-pass scanner
+
+FiltersModelReader::FiltersModelReader(FiltersModel & model) : _model(model)
+{
+}
+
+QString FiltersModelReader::filtersLanguage(const QByteArray & stdlibArray)
+{
   QString language;
   QList<QString> languages = QLocale().uiLanguages();
   if (languages.size()) {
@@ -54,121 +185,135 @@ void FiltersModelReader::parseFiltersDefinitions(QByteArray & stdlibArray)
   } else {
     language = "void";
   }
+  // Use _en locale if not localization for the language is found.
   if (!stdlibArray.contains(QString("#@gui_%1").arg(language).toLocal8Bit())) {
     language = "en";
   }
+  return language;
+}
 
-  // Use _en locale if not localization for the language is found.
+void FiltersModelReader::parseFiltersDefinitions(QByteArray & stdlibArray)
+{
+  // Single pass over the raw stdlib. Line matching below reproduces the former
+  // regular expressions (given in comments) without copying every line.
+  const char * const data = stdlibArray.constData();
+  const char * const dataEnd = data + stdlibArray.size();
+  QList<QString> filterPath;
+
+  const QString language = filtersLanguage(stdlibArray);
+  const QByteArray languageTag = QString("gui_%1").arg(language).toUtf8();
+
+  const QChar WarningPrefix('!');
+  Line buffer = nextLine(data, dataEnd);
+  while (!buffer.isEmpty()) {
+    const Line line = buffer.trimmed();
+    if (!line.startsWith("#@gui")) {
+      buffer = nextLine(buffer.end, dataEnd);
+      continue;
+    }
+    if (isFolderLine(line, languageTag)) {
+      //
+      // A folder
+      //
+      const int prefix = guiPrefixLength(line);
+      QString folderName = (prefix == -1) ? line.toString() : Line{line.begin + prefix, line.end}.toString();
 
-  QString buffer = stdlib.readLine(4096);
-  QString line;
+      while (folderName.startsWith("_") && filterPath.size()) {
+        folderName.remove(0, 1);
+        filterPath.pop_back();
+      }
+      while (folderName.startsWith("_")) {
+        folderName.remove(0, 1);
+      }
+      if (!folderName.isEmpty()) {
+        filterPath.push_back(folderName);
+      }
+      buffer = nextLine(buffer.end, dataEnd);
+    } else if (isFilterLine(line, languageTag)) {
+      //
+      // A filter
+      //
+      const char * colon = line.find(':');
 
-  QRegExp folderRegexpNoLanguage("^..gui[ ][^:]+$");
-  QRegExp folderRegexpLanguage(QString("^..gui_%1[ ][^:]+$").arg(language));
+      // "[ ]*:.*$" then "^..gui[_a-zA-Z]{0,3}[ ]" removed
+      Line name{line.begin, colon};
+      while (name.end > name.begin && name.end[-1] == ' ') {
+        --name.end;
+      }
+      const int namePrefix = guiPrefixLength(name);
+      if (namePrefix != -1) {
+        name.begin += namePrefix;
+      }
+      QString filterName = name.toString();
 
-  QRegExp filterRegexpNoLanguage("^..gui[ ][^:]+[ ]*:.*");
-  QRegExp filterRegexpLanguage(QString("^..gui_%1[ ][^:]+[ ]*:.*").arg(language));
+      const bool warning = filterName.startsWith(WarningPrefix);
+      if (warning) {
+        filterName.remove(0, 1);
+      }
 
-  const QChar WarningPrefix('!');
-  do {
-    line = buffer.trimmed();
-    if (line.startsWith("#@gui")) {
-      if (folderRegexpNoLanguage.exactMatch(line) || folderRegexpLanguage.exactMatch(line)) {
-        //
-        // A folder
-        //
-        QString folderName = line;
-        folderName.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ]"), "");
-
-        while (folderName.startsWith("_") && filterPath.size()) {
-          folderName.remove(0, 1);
-          filterPath.pop_back();
-        }
-        while (folderName.startsWith("_")) {
-          folderName.remove(0, 1);
-        }
-        if (!folderName.isEmpty()) {
-          filterPath.push_back(folderName);
-        }
-        buffer = stdlib.readLine(4096);
-      } else if (filterRegexpNoLanguage.exactMatch(line) || filterRegexpLanguage.exactMatch(line)) {
-        //
-        // A filter
-        //
-        QString filterName = line;
-        filterName.replace(QRegExp("[ ]*:.*$"), "");
-        filterName.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ]"), "");
-
-        const bool warning = filterName.startsWith(WarningPrefix);
-        if (warning) {
-          filterName.remove(0, 1);
+      // "^..gui[_a-zA-Z]{0,3}[ ][^:]+[ ]*:[ ]*" removed
+      Line commandsLine = line;
+      const int prefix = guiPrefixLength(line);
+      if (prefix != -1 && colon > line.begin + prefix) {
+        commandsLine.begin = colon + 1;
+        while (commandsLine.begin < commandsLine.end && *commandsLine.begin == ' ') {
+          ++commandsLine.begin;
         }
+      }
+      QString filterCommands = commandsLine.toString();
 
-        QString filterCommands = line;
-        filterCommands.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ][^:]+[ ]*:[ ]*"), "");
+      QList<QString> commands = filterCommands.split(",");
 
-        QList<QString> commands = filterCommands.split(",");
+      QString filterCommand = commands[0].trimmed();
+      if (commands.size() == 0) {
+        commands.push_back("_none_");
+      }
+      if (commands.size() == 1) {
+        commands.push_back(commands.front());
+      }
+      QList<QString> preview = commands[1].trimmed().split("(");
+      float previewFactor = GmicQt::PreviewFactorAny;
+      bool accurateIfZoomed = true;
+      bool tileSafe = false;
+      if (preview.size() >= 2) {
+        // Flags following the factor: '+' accurate if zoomed, '*' may be processed by tiles
+        const QString flags = preview[1].section(')', 1);
+        accurateIfZoomed = flags.contains('+');
+        tileSafe = flags.contains('*');
+        previewFactor = preview[1].left(preview[1].indexOf(')')).toFloat();
+      }
+      QString filterPreviewCommand = preview[0].trimmed();
 
-        QString filterCommand = commands[0].trimmed();
-        if (commands.size() == 0) {
-          commands.push_back("_none_");
-        }
-        if (commands.size() == 1) {
-          commands.push_back(commands.front());
-        }
-        QList<QString> preview = commands[1].trimmed().split("(");
-        float previewFactor = GmicQt::PreviewFactorAny;
-        bool accurateIfZoomed = true;
-        if (preview.size() >= 2) {
-          if (preview[1].endsWith("+")) {
-            accurateIfZoomed = true;
-            preview[1].chop(1);
-          } else {
-            accurateIfZoomed = false;
-          }
-          previewFactor = preview[1].replace(QRegExp("\\).*"), "").toFloat();
+      // Parameter lines start like the filter line, up to its first space
+      const char * space = line.find(' ');
+      const QByteArray start = QByteArray(line.begin, static_cast<int>(space - line.begin)) + " :";
+
+      // Read parameters
+      QByteArray parameters;
+      bool continued;
+      do {
+        buffer = nextLine(buffer.end, dataEnd);
+        if (buffer.startsWith(start)) {
+          parameters += parameterText(buffer);
         }
-        QString filterPreviewCommand = preview[0].trimmed();
-
-        //        FiltersTreeFilterItem * filterItem = new FiltersTreeFilterItem(filterName,
-        //                                                                       filterCommand,
-        //                                                                       filterPreviewCommand,
-        //                                                                       previewFactor,
-        //                                                                       accurateIfZoomed);
-        // filterItem->setWarningFlag(warning);
-
-        QString start = line;
-        start.replace(QRegExp(" .*"), " :");
-
-        // Read parameters
-        QString parameters;
-        do {
-          buffer = stdlib.readLine(4096);
-          if (buffer.startsWith(start)) {
-            QString parameterLine = buffer;
-            parameterLine.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ]*:[ ]*"), "");
-            parameters += parameterLine;
-          }
-        } while ((buffer.startsWith(start) || buffer.startsWith("#") || (buffer.trimmed().isEmpty() && !stdlib.atEnd())) && !folderRegexpNoLanguage.exactMatch(buffer) &&
-                 !folderRegexpLanguage.exactMatch(buffer) && !filterRegexpNoLanguage.exactMatch(buffer) && !filterRegexpLanguage.exactMatch(buffer));
-
-        FiltersModel::Filter filter;
-        filter.setName(filterName);
-        filter.setCommand(filterCommand);
-        filter.setPreviewCommand(filterPreviewCommand);
-        filter.setPreviewFactor(previewFactor);
-        filter.setAccurateIfZoomed(accurateIfZoomed);
-        filter.setParameters(parameters);
-        filter.setPath(filterPath);
-        filter.setWarningFlag(warning);
-        filter.build();
-        _model.addFilter(filter);
-
-      } else {
-        buffer = stdlib.readLine(4096);
-      }
+        continued = (buffer.startsWith(start) || buffer.startsWith("#") || (buffer.trimmed().isEmpty() && (buffer.end != dataEnd))) && //
+                    !isFolderLine(buffer, languageTag) && !isFilterLine(buffer, languageTag);
+      } while (continued);
+
+      FiltersModel::Filter filter;
+      filter.setName(filterName);
+      filter.setCommand(filterCommand);
+      filter.setPreviewCommand(filterPreviewCommand);
+      filter.setPreviewFactor(previewFactor);
+      filter.setAccurateIfZoomed(accurateIfZoomed);
+      filter.setTileSafe(tileSafe);
+      filter.setParameters(QString::fromUtf8(parameters));
+      filter.setPath(filterPath);
+      filter.setWarningFlag(warning);
+      filter.build();
+      _model.addFilter(filter);
     } else {
-      buffer = stdlib.readLine(4096);
+      buffer = nextLine(buffer.end, dataEnd);
     }
-  } while (!buffer.isEmpty());
+  }
 }
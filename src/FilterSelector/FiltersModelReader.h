@@ -27,11 +27,18 @@
 #include "FilterSelector/FiltersModel.h"
 
 class QByteArray;
+class QString;
 
 class FiltersModelReader {
 public:
   FiltersModelReader(FiltersModel & model);
   void parseFiltersDefinitions(QByteArray & stdlibArray);
+  static QString filtersLanguage(const QByteArray & stdlibArray);
+  /**
+   * @brief Version of the parser, to be incremented whenever the filters it
+   *        produces from the same stdlib may change (it invalidates caches).
+   */
+  static const int ParserVersion;
 
 private:
   FiltersModel & _model;
@@ -28,6 +28,7 @@
 #include "Common.h"
 #include "FilterSelector/FavesModelReader.h"
 #include "FilterSelector/FavesModelWriter.h"
+#include "FilterSelector/FiltersCatalogueCache.h"
 #include "FilterSelector/FiltersModelReader.h"
 #include "FiltersVisibilityMap.h"
 #include "Globals.h"
@@ -97,8 +98,20 @@ void FiltersPresenter::readFilters()
   if (GmicStdLib::Array.isEmpty()) {
     GmicStdLib::loadStdLib();
   }
+  TIMING;
+  if (FiltersCatalogueCache::read(_filtersModel, GmicStdLib::Array)) {
+    TIMING; // Warm start
+    return;
+  }
   FiltersModelReader filterModelReader(_filtersModel);
   filterModelReader.parseFiltersDefinitions(GmicStdLib::Array);
+  TIMING; // Cold start
+  FiltersCatalogueCache::write(_filtersModel, GmicStdLib::Array);
+}
+
+void FiltersPresenter::swapFiltersModel(FiltersModel & model)
+{
+  _filtersModel.swap(model);
 }
 
 void FiltersPresenter::readFaves()
@@ -334,6 +347,7 @@ void FiltersPresenter::setCurrentFilter(QString hash)
       _currentFilter.parameters = filter.parameters();
       _currentFilter.previewCommand = fave.previewCommand();
       _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
+      _currentFilter.isTileSafe = filter.isTileSafe();
       _currentFilter.previewFactor = filter.previewFactor();
     }
   } else if (_filtersModel.contains(hash)) {
@@ -347,6 +361,7 @@ void FiltersPresenter::setCurrentFilter(QString hash)
     _currentFilter.parameters = filter.parameters();
     _currentFilter.previewCommand = filter.previewCommand();
     _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
+    _currentFilter.isTileSafe = filter.isTileSafe();
     _currentFilter.previewFactor = filter.previewFactor();
   } else {
     _currentFilter.clear();
@@ -363,6 +378,7 @@ void FiltersPresenter::Filter::clear()
   hash.clear();
   plainTextName.clear();
   previewFactor = GmicQt::PreviewFactorAny;
+  isTileSafe = false;
   isAFave = false;
 }
 
@@ -44,6 +44,7 @@ public:
     QList<QString> defaultParameterValues;
     QString hash;
     bool isAccurateIfZoomed;
+    bool isTileSafe;
     float previewFactor;
     bool isAFave;
     void clear();
@@ -60,6 +61,7 @@ public:
 
   void clear();
   void readFilters();
+  void swapFiltersModel(FiltersModel & model);
   void readFaves();
   void importGmicGTKFaves();
   void saveFaves();
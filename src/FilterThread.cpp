@@ -25,14 +25,15 @@
 #include "FilterThread.h"
 #include <QDebug>
 #include <iostream>
+#include "GmicInterpreterPool.h"
 #include "GmicStdlib.h"
 #include "ImageConverter.h"
 #include "gmic.h"
 using namespace cimg_library;
 
 FilterThread::FilterThread(QObject * parent, const QString & name, const QString & command, const QString & arguments, const QString & environment, GmicQt::OutputMessageMode mode)
-    : QThread(parent), _command(command), _arguments(arguments), _environment(environment), _images(new cimg_library::CImgList<float>), _imageNames(new cimg_library::CImgList<char>), _name(name),
-      _messageMode(mode)
+    : QThread(parent), _command(command), _arguments(arguments), _environment(environment), _images(new cimg_library::CImgList<float>), _imageNames(new cimg_library::CImgList<char>), _gmicAbort(false),
+      _failed(false), _gmicProgress(-1), _name(name), _messageMode(mode), _interpreterPool(nullptr)
 {
   ENTERING;
 #ifdef _IS_MACOS_
@@ -46,11 +47,33 @@ FilterThread::~FilterThread()
   delete _imageNames;
 }
 
+void FilterThread::setup(const QString & name, const QString & command, const QString & arguments, const QString & environment, GmicQt::OutputMessageMode mode)
+{
+  Q_ASSERT_X(!isRunning(), __PRETTY_FUNCTION__, "Thread is running");
+  _name = name;
+  _command = command;
+  _arguments = arguments;
+  _environment = environment;
+  _messageMode = mode;
+  _images->assign();
+  _imageNames->assign();
+  _gmicAbort = false;
+  _failed = false;
+  _gmicProgress = -1;
+  _gmicStatus.clear();
+  _errorMessage.clear();
+}
+
 void FilterThread::setArguments(const QString & str)
 {
   _arguments = str;
 }
 
+void FilterThread::setInterpreterPool(GmicInterpreterPool * pool)
+{
+  _interpreterPool = pool;
+}
+
 void FilterThread::setImageNames(const cimg_library::CImgList<char> & imageNames)
 {
   *_imageNames = imageNames;
@@ -134,6 +157,10 @@ void FilterThread::run()
   _startTime.start();
   _errorMessage.clear();
   _failed = false;
+  if (_gmicAbort) {
+    // Aborted before it even started
+    return;
+  }
   if (!*_images) {
     _images->assign(1);
     _imageNames->assign(1);
@@ -150,17 +177,32 @@ void FilterThread::run()
       fullCommandLine = QString("debug");
     }
     fullCommandLine += QString(" %1 %2").arg(_command).arg(_arguments);
-    _gmicAbort = false;
     _gmicProgress = -1;
     if (_messageMode > GmicQt::Quiet) {
       std::fprintf(cimg::output(), "\n[gmic_qt] Command: %s\n", fullCommandLine.toLocal8Bit().constData());
       std::fflush(cimg::output());
     }
 
-    gmic gmicInstance(_environment.isEmpty() ? 0 : QString("v - %1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true);
-    gmicInstance.set_variable("_host", GmicQt::HostApplicationShortname, '=');
-    gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames, &_gmicProgress, &_gmicAbort);
-    _gmicStatus = gmicInstance.status;
+    if (_interpreterPool) {
+      gmic * interpreter = _interpreterPool->acquire(_environment);
+      try {
+        interpreter->run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames, &_gmicProgress, &_gmicAbort);
+      } catch (gmic_exception &) {
+        _interpreterPool->discard(interpreter);
+        throw;
+      }
+      _gmicStatus = interpreter->status;
+      if (_gmicAbort) {
+        _interpreterPool->discard(interpreter);
+      } else {
+        _interpreterPool->release(interpreter);
+      }
+    } else {
+      gmic gmicInstance(_environment.isEmpty() ? 0 : QString("v - %1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true);
+      gmicInstance.set_variable("_host", GmicQt::HostApplicationShortname, '=');
+      gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames, &_gmicProgress, &_gmicAbort);
+      _gmicStatus = gmicInstance.status;
+    }
   } catch (gmic_exception & e) {
     _images->assign();
     _imageNames->assign();
@@ -28,6 +28,7 @@
 #include <QThread>
 #include <QTime>
 
+class GmicInterpreterPool;
 class ImageSource;
 class QMutex;
 class QImage;
@@ -58,8 +59,10 @@ public:
   FilterThread(QObject * parent, const QString & name, const QString & command, const QString & arguments, const QString & environment, GmicQt::OutputMessageMode mode);
 
   virtual ~FilterThread();
+  void setup(const QString & name, const QString & command, const QString & arguments, const QString & environment, GmicQt::OutputMessageMode mode);
   void run();
   void setArguments(const QString &);
+  void setInterpreterPool(GmicInterpreterPool * pool);
   void setInputImages(const cimg_library::CImgList<float> & list);
   void setImageNames(const cimg_library::CImgList<char> & imageNames);
   void swapImages(cimg_library::CImgList<float> & images);
@@ -95,6 +98,7 @@ private:
   QString _name;
   GmicQt::OutputMessageMode _messageMode;
   QTime _startTime;
+  GmicInterpreterPool * _interpreterPool;
 };
 
 #endif // _GMIC_QT__FILTERTHREAD_H_
@@ -38,7 +38,10 @@ extern const float PreviewFactorActualSize;
 
 #define SLIDER_MIN_WIDTH 60
 #define PARAMETERS_CACHE_FILENAME "gmic_qt_params.dat"
+#define PARAMETERS_CACHE_JOURNAL_FILENAME "gmic_qt_params.journal"
 #define FILTERS_VISIBILITY_FILENAME "gmic_qt_visibility.dat"
+#define FILTERS_CATALOGUE_CACHE_FILENAME "gmic_qt_filters.dat"
+#define STDLIB_CACHE_FILENAME "gmic_qt_stdlib.dat"
 
 #define FAVE_FOLDER_TEXT "<b>Faves</b>"
 #define FAVES_IMPORT_KEY "Faves/ImportedGTK179"
@@ -50,4 +53,7 @@ extern const float PreviewFactorActualSize;
 
 #define PREVIEW_MAX_ZOOM_FACTOR 40.0
 
+// Images with at least this number of pixels are converted using all cores (with OpenMP)
+#define PARALLEL_CONVERSION_MIN_PIXELS (512 * 512)
+
 #endif // _GMIC_QT_GLOBALS_H_
@@ -0,0 +1,209 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file GmicInterpreterPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "GmicInterpreterPool.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QStringList>
+#include "GmicStdlib.h"
+#include "Host/host.h"
+#include "gmic.h"
+
+GmicInterpreterPool::GmicInterpreterPool(int maxIdleInterpreters) : _maxIdleInterpreters(maxIdleInterpreters), _createdCount(0) {}
+
+GmicInterpreterPool::~GmicInterpreterPool()
+{
+  clear();
+}
+
+gmic * GmicInterpreterPool::acquire(const QString & environment)
+{
+  const QString signature = environmentSignature(environment);
+  gmic * interpreter = nullptr;
+  {
+    QMutexLocker locker(&_mutex);
+    flushIfStdlibChanged();
+    for (int index = _idle.size() - 1; index >= 0; --index) {
+      if (_signatures.value(_idle[index]) == signature) {
+        interpreter = _idle.takeAt(index);
+        break;
+      }
+    }
+  }
+  if (!interpreter) {
+    QByteArray stdlib = GmicStdLib::Array;
+    interpreter = new gmic(0, stdlib.constData(), true);
+    const quint64 commands = commandsChecksum(*interpreter);
+    QMutexLocker locker(&_mutex);
+    _stdlibs[interpreter] = stdlib;
+    _commands[interpreter] = commands;
+    ++_createdCount;
+  }
+
+  // Per-run state. Local variables are dropped by G'MIC at the end of each run,
+  // global ones (_*) set by the previous environment are all assigned again here.
+  try {
+    interpreter->status.assign();
+    interpreter->set_variable("_host", GmicQt::HostApplicationShortname, '=');
+    if (!environment.isEmpty()) {
+      gmic_list<float> images;
+      gmic_list<char> imageNames;
+      interpreter->run(QString("v - %1").arg(environment).toLocal8Bit().constData(), images, imageNames);
+    }
+  } catch (gmic_exception &) {
+    discard(interpreter);
+    throw;
+  }
+  const QByteArray globals = globalVariables(*interpreter);
+  QMutexLocker locker(&_mutex);
+  _signatures[interpreter] = signature;
+  _globals[interpreter] = globals;
+  return interpreter;
+}
+
+void GmicInterpreterPool::release(gmic * interpreter)
+{
+  if (!interpreter) {
+    return;
+  }
+  // A filter which assigned global variables or defined commands would leave
+  // them to the next run
+  const QByteArray globals = globalVariables(*interpreter);
+  const quint64 commands = commandsChecksum(*interpreter);
+  QMutexLocker locker(&_mutex);
+  flushIfStdlibChanged();
+  const bool stateChanged = (globals != _globals.value(interpreter)) || (commands != _commands.value(interpreter));
+  if (stateChanged || (_stdlibs.value(interpreter).constData() != _stdlib.constData()) || (_idle.size() >= _maxIdleInterpreters)) {
+    forget(interpreter);
+    delete interpreter;
+    return;
+  }
+  _idle.push_back(interpreter);
+}
+
+void GmicInterpreterPool::discard(gmic * interpreter)
+{
+  if (!interpreter) {
+    return;
+  }
+  QMutexLocker locker(&_mutex);
+  forget(interpreter);
+  delete interpreter;
+}
+
+void GmicInterpreterPool::clear()
+{
+  QMutexLocker locker(&_mutex);
+  deleteIdleInterpreters();
+}
+
+int GmicInterpreterPool::idleCount() const
+{
+  QMutexLocker locker(&_mutex);
+  return _idle.size();
+}
+
+int GmicInterpreterPool::createdCount() const
+{
+  QMutexLocker locker(&_mutex);
+  return _createdCount;
+}
+
+void GmicInterpreterPool::flushIfStdlibChanged()
+{
+  // GmicStdLib::Array is implicitly shared: same data pointer means same stdlib.
+  if (_stdlib.constData() == GmicStdLib::Array.constData()) {
+    return;
+  }
+  deleteIdleInterpreters();
+  _stdlib = GmicStdLib::Array;
+}
+
+void GmicInterpreterPool::deleteIdleInterpreters()
+{
+  for (gmic * interpreter : _idle) {
+    forget(interpreter);
+    delete interpreter;
+  }
+  _idle.clear();
+}
+
+void GmicInterpreterPool::forget(gmic * interpreter)
+{
+  _stdlibs.remove(interpreter);
+  _signatures.remove(interpreter);
+  _globals.remove(interpreter);
+  _commands.remove(interpreter);
+}
+
+QString GmicInterpreterPool::environmentSignature(const QString & environment)
+{
+  // Sorted names of the assigned variables, e.g. "_input_layers _output_mode ..."
+  QStringList names;
+  for (const QString & assignment : environment.split(QChar(' '), QString::SkipEmptyParts)) {
+    names.push_back(assignment.section(QChar('='), 0, 0));
+  }
+  names.sort();
+  return names.join(QChar(' '));
+}
+
+QByteArray GmicInterpreterPool::globalVariables(const gmic & interpreter)
+{
+  // Variables whose names start with '_' live in the upper half of the
+  // variable slots, the lower half holding the local variables of a run.
+  QByteArray result;
+  for (unsigned int slot = gmic_varslots / 2; slot < gmic_varslots; ++slot) {
+    const gmic_list<char> & names = *interpreter.variables_names[slot];
+    const gmic_list<char> & values = *interpreter.variables[slot];
+    for (unsigned int i = 0; i < values._width; ++i) {
+      result.append(names[i]._data, static_cast<int>(names[i].size()));
+      result.append('=');
+      result.append(values[i]._data, static_cast<int>(values[i].size()));
+      result.append('\n');
+    }
+  }
+  return result;
+}
+
+quint64 GmicInterpreterPool::commandsChecksum(const gmic & interpreter)
+{
+  // FNV-1a over the names and bodies of all the defined commands
+  quint64 hash = 14695981039346656037ULL;
+  auto add = [&hash](const gmic_image<char> & text) {
+    const char * end = text._data + text.size();
+    for (const char * c = text._data; c < end; ++c) {
+      hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0xFFu) * 1099511628211ULL;
+  };
+  for (unsigned int slot = 0; slot < gmic_comslots; ++slot) {
+    const gmic_list<char> & names = interpreter.commands_names[slot];
+    const gmic_list<char> & bodies = interpreter.commands[slot];
+    for (unsigned int i = 0; i < names._width; ++i) {
+      add(names[i]);
+      add(bodies[i]);
+    }
+  }
+  return hash;
+}
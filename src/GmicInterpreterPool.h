@@ -0,0 +1,100 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file GmicInterpreterPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_GMICINTERPRETERPOOL_H_
+#define _GMIC_QT_GMICINTERPRETERPOOL_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+struct gmic;
+
+/**
+ * @brief A set of G'MIC interpreters with the stdlib already loaded.
+ *
+ * Building a gmic instance parses the whole stdlib, which dominates the
+ * cost of a small preview. Interpreters are handed to one filter thread
+ * at a time and given back once the command has run successfully.
+ * The pool is flushed as soon as GmicStdLib::Array is replaced.
+ *
+ * Variables whose names start with '_' are interpreter globals and survive
+ * a run, as do the commands a filter defines. An idle interpreter is therefore
+ * only reused with an environment assigning the very same variables, and an
+ * interpreter whose run assigned global variables or changed the command
+ * table is not kept.
+ */
+class GmicInterpreterPool {
+public:
+  GmicInterpreterPool(int maxIdleInterpreters = DefaultMaxIdleInterpreters);
+  ~GmicInterpreterPool();
+
+  /**
+   * @brief Get an interpreter, ready to run a command in the given environment
+   *
+   * @param environment Space-separated list of variable assignments (may be empty)
+   * @return An interpreter owned by the caller until release() or discard() is called
+   */
+  gmic * acquire(const QString & environment);
+
+  /**
+   * @brief Give back an interpreter which ran a command normally
+   */
+  void release(gmic * interpreter);
+
+  /**
+   * @brief Destroy an interpreter whose state cannot be trusted
+   *        (failed or aborted run)
+   */
+  void discard(gmic * interpreter);
+
+  void clear();
+  int idleCount() const;
+  int createdCount() const;
+
+  static const int DefaultMaxIdleInterpreters = 2;
+
+private:
+  GmicInterpreterPool(const GmicInterpreterPool &) = delete;
+  GmicInterpreterPool & operator=(const GmicInterpreterPool &) = delete;
+  void flushIfStdlibChanged();
+  void deleteIdleInterpreters();
+  void forget(gmic * interpreter);
+  static QString environmentSignature(const QString & environment);
+  static QByteArray globalVariables(const gmic & interpreter);
+  static quint64 commandsChecksum(const gmic & interpreter);
+  mutable QMutex _mutex;
+  QList<gmic *> _idle;
+  QHash<gmic *, QByteArray> _stdlibs;           // Stdlib each live interpreter was built from
+  QHash<gmic *, QString> _signatures;           // Variables assigned by the environment of the last run
+  QHash<gmic *, QByteArray> _globals;           // Global variables and values before the last run
+  QHash<gmic *, quint64> _commands;             // Checksum of the command table when built
+  QByteArray _stdlib;
+  int _maxIdleInterpreters;
+  int _createdCount;
+};
+
+#endif // _GMIC_QT_GMICINTERPRETERPOOL_H_
@@ -29,19 +29,45 @@
 #include <QRegExp>
 #include <QSize>
 #include <QString>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include "FilterThread.h"
+#include "GmicStdlib.h"
 #include "Host/host.h"
 #include "ImageConverter.h"
 #include "ImageTools.h"
 #include "LayersExtentProxy.h"
+#include "PreviewCache.h"
 #include "gmic.h"
 
+namespace
+{
+// Variables of the preview environment only (see GmicProcessor::previewEnvironment())
+const QList<QByteArray> PreviewVariables = QList<QByteArray>() << "_preview_width" << "_preview_height" << "_preview_timeout";
+}
+
 GmicProcessor::GmicProcessor(QObject * parent) : QObject(parent)
 {
   _filterThread = nullptr;
   _gmicImages = new cimg_library::CImgList<gmic_pixel_type>;
   _previewImage = new cimg_library::CImg<float>;
+  _previewInput = new cimg_library::CImgList<gmic_pixel_type>;
+  _previewImageNames = new cimg_library::CImgList<char>;
+  _previewOutput = new cimg_library::CImgList<gmic_pixel_type>;
+  _previewOutputNames = new cimg_library::CImgList<char>;
+  _previewStage = LAST_PREVIEW_STAGE;
+  _speculating = false;
+  _speculativeRequestPending = false;
+  _speculativeInput = new cimg_library::CImgList<gmic_pixel_type>;
+  _speculativeImageNames = new cimg_library::CImgList<char>;
+  _tiledResult = new cimg_library::CImg<gmic_pixel_type>;
+  _tiledImageNames = new cimg_library::CImgList<char>;
+  _currentTile = 0;
+  _tiledSpectrum = 0;
+  _tiledOutputStarted = false;
+  _deferredRequest = NoDeferredRequest;
+  _lastCancelToIdleDuration = 0;
   _waitingCursorTimer.setSingleShot(true);
   connect(&_waitingCursorTimer, SIGNAL(timeout()), this, SLOT(showWaitingCursor()));
   _previewRandomSeed = cimg_library::cimg::srand();
@@ -52,6 +78,11 @@ void GmicProcessor::init()
 {
   abortCurrentFilterThread();
   _gmicImages->assign();
+  _previewInput->assign();
+  _speculativeInput->assign();
+  _speculativeImageNames->assign();
+  _speculativeInputKey.clear();
+  clearTiledProcessing();
 }
 
 void GmicProcessor::setContext(const GmicProcessor::FilterContext & context)
@@ -61,11 +92,44 @@ void GmicProcessor::setContext(const GmicProcessor::FilterContext & context)
 
 void GmicProcessor::execute()
 {
+  if (_filterContext.requestType == FilterContext::PreviewProcessing) {
+    clearPreviewOutput();
+    _previewCacheKey = previewCacheKey();
+    if (!_previewCacheKey.isEmpty() && PreviewCache::find(_previewCacheKey, *_previewImage, _gmicStatus, _previewRandomSeed)) {
+      emit previewImageAvailable();
+      return;
+    }
+  }
+  if ((_filterContext.requestType == FilterContext::PreviewProcessing) && tooManyUnfinishedAbortedThreads()) {
+    _deferredRequest = DeferredPreview;
+    return;
+  }
+  const QString env = environment();
+  if (_filterContext.requestType == FilterContext::FullImageProcessing) {
+    _lastAppliedFilterName = _filterContext.filterName;
+    _lastAppliedCommand = _filterContext.filterCommand;
+    _lastAppliedCommandArguments = _filterContext.filterArguments;
+    _lastAppliedCommandEnv = env;
+    _lastAppliedCommandInOutState = _filterContext.inputOutputState;
+    if (!_previewOutputKey.isEmpty() && (_previewOutputKey == previewOutputKey(env)) && _previewOutput->size()) {
+      outputPreviewResult();
+      return;
+    }
+    clearPreviewOutput(); // Input image is about to change
+    if (shouldProcessByTiles()) {
+      _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
+      startTiledProcessing();
+      return;
+    }
+  }
   gmic_list<char> imageNames;
   FilterContext::VisibleRect & rect = _filterContext.visibleRect;
   _gmicImages->assign();
   gmic_qt_get_cropped_images(*_gmicImages, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode);
   if (_filterContext.requestType == FilterContext::PreviewProcessing) {
+    if (previewCoversFullImage()) {
+      *_previewOutputNames = imageNames;
+    }
     updateImageNames(imageNames);
     const double & zoomFactor = _filterContext.zoomFactor;
     if (zoomFactor < 1.0) {
@@ -76,32 +140,201 @@ void GmicProcessor::execute()
     }
   }
   _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
-  const GmicQt::InputOutputState & io = _filterContext.inputOutputState;
-  QString env = QString("_input_layers=%1").arg(io.inputMode);
-  env += QString(" _output_mode=%1").arg(io.outputMode);
-  env += QString(" _output_messages=%1").arg(io.outputMessageMode);
-  env += QString(" _preview_mode=%1").arg(io.previewMode);
   if (_filterContext.requestType == FilterContext::PreviewProcessing) {
-    env += QString(" _preview_width=%1").arg(_filterContext.previewWidth);
-    env += QString(" _preview_height=%1").arg(_filterContext.previewHeight);
-    env += QString(" _preview_timeout=%1").arg(_filterContext.previewTimeout);
-    _filterThread = new FilterThread(this, _filterContext.filterName, _filterContext.filterCommand, _filterContext.filterArguments, env, _filterContext.inputOutputState.outputMessageMode);
-    _filterThread->swapImages(*_gmicImages);
-    _filterThread->setImageNames(imageNames);
-    connect(_filterThread, SIGNAL(finished()), this, SLOT(onPreviewThreadFinished()));
+    _previewEnvironment = env;
+    _previewInput->swap(*_gmicImages);
+    _previewImageNames->swap(imageNames);
     _previewRandomSeed = cimg_library::cimg::srand();
+    // The full image is processed without the _preview_* variables
+    if (previewCoversFullImage() && !GmicStdLib::commandMentions(_filterContext.filterCommand, PreviewVariables)) {
+      _previewOutputKey = previewOutputKey(env);
+    }
+    _previewStage = firstPreviewStage();
+    startPreviewStage();
   } else if (_filterContext.requestType == FilterContext::FullImageProcessing) {
-    _lastAppliedFilterName = _filterContext.filterName;
-    _lastAppliedCommand = _filterContext.filterCommand;
-    _lastAppliedCommandArguments = _filterContext.filterArguments;
-    _lastAppliedCommandEnv = env;
-    _lastAppliedCommandInOutState = _filterContext.inputOutputState;
-    _filterThread = new FilterThread(this, _filterContext.filterName, _filterContext.filterCommand, _filterContext.filterArguments, env, _filterContext.inputOutputState.outputMessageMode);
+    _filterThread = newFilterThread(env, SLOT(onApplyThreadFinished()));
     _filterThread->swapImages(*_gmicImages);
     _filterThread->setImageNames(imageNames);
-    connect(_filterThread, SIGNAL(finished()), this, SLOT(onApplyThreadFinished()));
     cimg_library::cimg::srand(_previewRandomSeed);
+    _filterThread->start();
+  }
+}
+
+void GmicProcessor::speculate(const GmicProcessor::FilterContext & context)
+{
+  if (_filterThread && isProcessingFullImage()) {
+    return;
+  }
+  if (_filterThread && _speculating) {
+    // Keep a single speculative run in flight; only the latest request is kept for later
+    _speculativeContext = context;
+    _speculativeRequestPending = true;
+    return;
+  }
+  abortCurrentFilterThread();
+  if (tooManyUnfinishedAbortedThreads()) {
+    _speculativeContext = context;
+    _deferredRequest = DeferredSpeculativePreview;
+    return;
+  }
+  _filterContext = context;
+  startSpeculativePreview();
+}
+
+QString GmicProcessor::environment() const
+{
+  const GmicQt::InputOutputState & io = _filterContext.inputOutputState;
+  QString env = QString("_input_layers=%1").arg(io.inputMode);
+  env += QString(" _output_mode=%1").arg(io.outputMode);
+  env += QString(" _output_messages=%1").arg(io.outputMessageMode);
+  env += QString(" _preview_mode=%1").arg(io.previewMode);
+  return env;
+}
+
+bool GmicProcessor::shouldProcessByTiles() const
+{
+  // Tiles are fetched through normalized coordinates, which only make sense for a single layer
+  if (!_filterContext.tiledProcessing || (_filterContext.inputOutputState.inputMode != GmicQt::Active)) {
+    return false;
+  }
+  int width;
+  int height;
+  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, width, height);
+  return (width > _filterContext.tileSize) || (height > _filterContext.tileSize);
+}
+
+void GmicProcessor::startTiledProcessing()
+{
+  int width;
+  int height;
+  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, width, height);
+  _tiledImageSize = QSize(width, height);
+  clearTiledProcessing();
+  const int size = _filterContext.tileSize;
+  for (int y = 0; y < height; y += size) {
+    for (int x = 0; x < width; x += size) {
+      _tiles.push_back(QRect(x, y, std::min(size, width - x), std::min(size, height - y)));
+    }
+  }
+  _tiledImageNames->assign();
+  _currentTile = 0;
+  _tiledProcessingTime.start();
+  processNextTile();
+}
+
+void GmicProcessor::processNextTile()
+{
+  const QRect & tile = _tiles[_currentTile];
+  const int halo = _filterContext.tileHalo;
+  const QRect haloTile = tile.adjusted(-halo, -halo, halo, halo).intersected(QRect(QPoint(0, 0), _tiledImageSize));
+
+  // Host returns "entire pixels": shift by half a pixel so that the top-left corner is exact,
+  // and crop whatever extra column/row may come along.
+  const double width = _tiledImageSize.width();
+  const double height = _tiledImageSize.height();
+  gmic_list<float> images;
+  gmic_list<char> imageNames;
+  gmic_qt_get_cropped_images(images, imageNames, (haloTile.x() + 0.5) / width, (haloTile.y() + 0.5) / height, haloTile.width() / width, haloTile.height() / height, _filterContext.inputOutputState.inputMode);
+  if ((images.size() != 1) || (images[0].width() < haloTile.width()) || (images[0].height() < haloTile.height())) {
+    // Host did not return the requested area (e.g. layer changed meanwhile): process the image as a whole
+    abandonTiledProcessing();
+    return;
+  }
+  images[0].crop(0, 0, haloTile.width() - 1, haloTile.height() - 1);
+  if (_currentTile == 0) {
+    *_tiledImageNames = imageNames;
   }
+
+  _filterThread = newFilterThread(environment(), SLOT(onTileThreadFinished()));
+  _filterThread->swapImages(images);
+  _filterThread->setImageNames(imageNames);
+  cimg_library::cimg::srand(_previewRandomSeed);
+  _filterThread->start();
+}
+
+int GmicProcessor::firstPreviewStage() const
+{
+  if (!_filterContext.progressivePreview) {
+    return LAST_PREVIEW_STAGE;
+  }
+  // Filters known to be fast are not worth the extra low resolution runs
+  if (_previewDurations.contains(_filterContext.filterCommand) && (_previewDurations[_filterContext.filterCommand] < PROGRESSIVE_PREVIEW_MIN_DURATION)) {
+    return LAST_PREVIEW_STAGE;
+  }
+  unsigned long pixels = 0;
+  for (unsigned int i = 0; i < _previewInput->size(); ++i) {
+    pixels = std::max(pixels, (unsigned long)(*_previewInput)[i].width() * (*_previewInput)[i].height());
+  }
+  return (pixels < PROGRESSIVE_PREVIEW_MIN_PIXELS) ? LAST_PREVIEW_STAGE : 0;
+}
+
+double GmicProcessor::previewStageScale(int stage)
+{
+  static const double scales[LAST_PREVIEW_STAGE + 1] = {0.25, 0.5, 1.0};
+  return scales[stage];
+}
+
+void GmicProcessor::startPreviewStage()
+{
+  const double scale = previewStageScale(_previewStage);
+  gmic_list<float> images;
+  if (_previewStage == LAST_PREVIEW_STAGE) {
+    images.swap(*_previewInput);
+  } else {
+    images.assign(_previewInput->size());
+    for (unsigned int i = 0; i < _previewInput->size(); ++i) {
+      const gmic_image<float> & image = (*_previewInput)[i];
+      image.get_resize(std::max(1, (int)std::round(image.width() * scale)), std::max(1, (int)std::round(image.height() * scale)), 1, -100, 2).move_to(images[i]);
+    }
+  }
+  const QString env = previewEnvironment(_previewEnvironment, scale);
+  _filterThread = newFilterThread(env, SLOT(onPreviewThreadFinished()));
+  _filterThread->swapImages(images);
+  _filterThread->setImageNames(*_previewImageNames);
+  cimg_library::cimg::srand(_previewRandomSeed); // All stages use the seed that Apply will use
+  _filterThread->start();
+}
+
+QString GmicProcessor::previewEnvironment(const QString & env, double scale) const
+{
+  QString result = env;
+  result += QString(" _preview_width=%1").arg((int)std::round(_filterContext.previewWidth * scale));
+  result += QString(" _preview_height=%1").arg((int)std::round(_filterContext.previewHeight * scale));
+  result += QString(" _preview_timeout=%1").arg(_filterContext.previewTimeout);
+  return result;
+}
+
+QString GmicProcessor::speculativeInputKey() const
+{
+  const FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+  return QString("%1 %2 %3 %4 %5 %6").arg(rect.x).arg(rect.y).arg(rect.w).arg(rect.h).arg(_filterContext.zoomFactor).arg(_filterContext.inputOutputState.inputMode);
+}
+
+void GmicProcessor::startSpeculativePreview()
+{
+  const double scale = previewStageScale(0);
+  const QString key = speculativeInputKey();
+  if (key != _speculativeInputKey) {
+    // Input is fetched once per slider drag
+    gmic_list<char> imageNames;
+    gmic_list<float> images;
+    FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+    gmic_qt_get_cropped_images(images, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode);
+    updateImageNames(imageNames);
+    const double factor = std::min(1.0, _filterContext.zoomFactor) * scale;
+    _speculativeInput->assign(images.size());
+    for (unsigned int i = 0; i < images.size(); ++i) {
+      images[i].get_resize(std::max(1, (int)std::round(images[i].width() * factor)), std::max(1, (int)std::round(images[i].height() * factor)), 1, -100, 2).move_to((*_speculativeInput)[i]);
+    }
+    _speculativeImageNames->swap(imageNames);
+    _speculativeInputKey = key;
+  }
+  gmic_list<float> images(*_speculativeInput);
+  _speculating = true;
+  _filterThread = newFilterThread(previewEnvironment(environment(), scale), SLOT(onSpeculativeThreadFinished()));
+  _filterThread->swapImages(images);
+  _filterThread->setImageNames(*_speculativeImageNames);
+  cimg_library::cimg::srand(_previewRandomSeed);
   _filterThread->start();
 }
 
@@ -115,8 +348,16 @@ bool GmicProcessor::isProcessing() const
   return _filterThread;
 }
 
+int GmicProcessor::lastCancelToIdleDuration() const
+{
+  return _lastCancelToIdleDuration;
+}
+
 int GmicProcessor::duration() const
 {
+  if (_filterThread && !_tiles.isEmpty()) {
+    return _tiledProcessingTime.elapsed();
+  }
   if (_filterThread) {
     return _filterThread->duration();
   } else {
@@ -126,6 +367,9 @@ int GmicProcessor::duration() const
 
 float GmicProcessor::progress() const
 {
+  if (_filterThread && !_tiles.isEmpty()) {
+    return 100.0f * (_currentTile + std::max(0.0f, _filterThread->progress()) / 100.0f) / _tiles.size();
+  }
   if (_filterThread) {
     return _filterThread->progress();
   } else {
@@ -167,22 +411,52 @@ void GmicProcessor::saveSettings(QSettings & settings)
 
 GmicProcessor::~GmicProcessor()
 {
+  // Filter threads are deleted as QObject children, after _interpreterPool:
+  // none of them may still be running (and using the pool) at that point.
+  if (_filterThread) {
+    _filterThread->disconnect(this);
+    _filterThread->abortGmic();
+    _filterThread->wait();
+  }
+  for (FilterThread * thread : _unfinishedAbortedThreads) {
+    thread->disconnect(this);
+    thread->wait();
+  }
+  _unfinishedAbortedThreads.clear();
+  for (FilterThread * thread : _idleFilterThreads) {
+    thread->wait();
+  }
+  clearTiledProcessing();
   delete _gmicImages;
   delete _previewImage;
-  if (_unfinishedAbortedThreads.size()) {
-    qWarning() << QString("Error: ~GmicProcessor(): There are %1 unfinished filter threads.").arg(_unfinishedAbortedThreads.size());
-  }
+  delete _previewInput;
+  delete _previewImageNames;
+  delete _previewOutput;
+  delete _previewOutputNames;
+  delete _speculativeInput;
+  delete _speculativeImageNames;
+  delete _tiledResult;
+  delete _tiledImageNames;
 }
 
 void GmicProcessor::onPreviewThreadFinished()
 {
   Q_ASSERT_X(_filterThread, __PRETTY_FUNCTION__, "No filter thread");
   Q_ASSERT_X(_filterThread == sender(), __PRETTY_FUNCTION__, "Wrong sender");
+  if (_filterThread->failed() && (_previewStage < LAST_PREVIEW_STAGE)) {
+    // Some filters cannot handle a downscaled input: go straight to full size
+    recycleFilterThread(_filterThread);
+    _filterThread = nullptr;
+    _previewStage = LAST_PREVIEW_STAGE;
+    startPreviewStage();
+    return;
+  }
   if (_filterThread->failed()) {
     _gmicStatus.clear();
     _gmicImages->assign();
+    _previewInput->assign();
     QString message = _filterThread->errorMessage();
-    _filterThread->deleteLater();
+    recycleFilterThread(_filterThread);
     _filterThread = nullptr;
     hideWaitingCursor();
     emit previewCommandFailed(message);
@@ -191,16 +465,65 @@ void GmicProcessor::onPreviewThreadFinished()
   _gmicStatus = _filterThread->gmicStatus();
   _gmicImages->assign();
   _filterThread->swapImages(*_gmicImages);
+  if ((_previewStage == LAST_PREVIEW_STAGE) && !_previewOutputKey.isEmpty()) {
+    *_previewOutput = *_gmicImages;
+    _previewOutputStatus = _gmicStatus;
+  }
   for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
     gmic_qt_apply_color_profile((*_gmicImages)[i]);
   }
   GmicQt::buildPreviewImage(*_gmicImages, *_previewImage, _filterContext.inputOutputState.previewMode, _filterContext.previewWidth, _filterContext.previewHeight);
-  _filterThread->deleteLater();
+  if (_previewStage < LAST_PREVIEW_STAGE) {
+    // Intermediate stage: publish an upscaled approximation, then refine
+    const double scale = previewStageScale(_previewStage);
+    _previewImage->resize((int)std::round(_previewImage->width() / scale), (int)std::round(_previewImage->height() / scale), 1, -100, 3);
+    recycleFilterThread(_filterThread);
+    _filterThread = nullptr;
+    ++_previewStage;
+    startPreviewStage();
+    emit previewImageAvailable();
+    return;
+  }
+  _previewDurations[_filterContext.filterCommand] = _filterThread->duration();
+  if (!_previewCacheKey.isEmpty()) {
+    PreviewCache::insert(_previewCacheKey, *_previewImage, _gmicStatus, _previewRandomSeed);
+  }
+  recycleFilterThread(_filterThread);
   _filterThread = nullptr;
   hideWaitingCursor();
   emit previewImageAvailable();
 }
 
+void GmicProcessor::onSpeculativeThreadFinished()
+{
+  Q_ASSERT_X(_filterThread, __PRETTY_FUNCTION__, "No filter thread");
+  Q_ASSERT_X(_filterThread == sender(), __PRETTY_FUNCTION__, "Wrong sender");
+  _speculating = false;
+  const bool failed = _filterThread->failed();
+  if (!failed) {
+    // Errors are left for the final preview to report
+    _gmicImages->assign();
+    _filterThread->swapImages(*_gmicImages);
+    for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
+      gmic_qt_apply_color_profile((*_gmicImages)[i]);
+    }
+    GmicQt::buildPreviewImage(*_gmicImages, *_previewImage, _filterContext.inputOutputState.previewMode, _filterContext.previewWidth, _filterContext.previewHeight);
+    const double scale = previewStageScale(0);
+    _previewImage->resize((int)std::round(_previewImage->width() / scale), (int)std::round(_previewImage->height() / scale), 1, -100, 3);
+    _gmicImages->assign();
+  }
+  recycleFilterThread(_filterThread);
+  _filterThread = nullptr;
+  if (_speculativeRequestPending) {
+    _speculativeRequestPending = false;
+    _filterContext = _speculativeContext;
+    startSpeculativePreview();
+  }
+  if (!failed) {
+    emit speculativePreviewImageAvailable();
+  }
+}
+
 void GmicProcessor::onApplyThreadFinished()
 {
   Q_ASSERT_X(_filterThread, __PRETTY_FUNCTION__, "No filter thread");
@@ -215,29 +538,129 @@ void GmicProcessor::onApplyThreadFinished()
     _lastAppliedCommandArguments.clear();
     _lastAppliedCommandInOutState.outputMessageMode = GmicQt::Quiet;
     QString message = _filterThread->errorMessage();
-    _filterThread->deleteLater();
+    recycleFilterThread(_filterThread);
     _filterThread = nullptr;
     emit fullImageProcessingFailed(message);
   } else {
     _filterThread->swapImages(*_gmicImages);
+    PreviewCache::clear(); // Input image is about to change
     if (_filterContext.inputOutputState.outputMessageMode == GmicQt::VerboseLayerName) {
       QString label = QString("[G'MIC] %1: %2").arg(_filterThread->name()).arg(_filterThread->fullCommand());
       gmic_qt_output_images(*_gmicImages, _filterThread->imageNames(), _filterContext.inputOutputState.outputMode, label.toLocal8Bit().constData());
     } else {
       gmic_qt_output_images(*_gmicImages, _filterThread->imageNames(), _filterContext.inputOutputState.outputMode, 0);
     }
-    _filterThread->deleteLater();
+    recycleFilterThread(_filterThread);
     _filterThread = nullptr;
     emit fullImageProcessingDone();
   }
 }
 
+void GmicProcessor::onTileThreadFinished()
+{
+  Q_ASSERT_X(_filterThread, __PRETTY_FUNCTION__, "No filter thread");
+  Q_ASSERT_X(_filterThread == sender(), __PRETTY_FUNCTION__, "Wrong sender");
+  if (_filterThread->failed()) {
+    clearTiledProcessing();
+    onApplyThreadFinished();
+    return;
+  }
+  _gmicStatus = _filterThread->gmicStatus();
+  gmic_list<float> images;
+  _filterThread->swapImages(images);
+  const QRect & tile = _tiles[_currentTile];
+  const int halo = _filterContext.tileHalo;
+  const QRect haloTile = tile.adjusted(-halo, -halo, halo, halo).intersected(QRect(QPoint(0, 0), _tiledImageSize));
+  const bool sameGeometry = (images.size() == 1) && (images[0].width() == haloTile.width()) && (images[0].height() == haloTile.height()) &&
+                            (!_currentTile || (images[0].spectrum() == _tiledSpectrum));
+  recycleFilterThread(_filterThread);
+  _filterThread = nullptr;
+  if (!sameGeometry) {
+    // Not tile-safe after all (e.g. filter changes the image size): process the image as a whole
+    abandonTiledProcessing();
+    return;
+  }
+  const int dx = tile.x() - haloTile.x();
+  const int dy = tile.y() - haloTile.y();
+  gmic_image<float> result = images[0].get_crop(dx, dy, dx + tile.width() - 1, dy + tile.height() - 1);
+  images.assign();
+  const GmicQt::InputOutputState & io = _filterContext.inputOutputState;
+  const QByteArray label = (io.outputMessageMode == GmicQt::VerboseLayerName)
+                               ? QString("[G'MIC] %1: %2 %3").arg(_filterContext.filterName).arg(_filterContext.filterCommand).arg(_filterContext.filterArguments).toLocal8Bit()
+                               : QByteArray();
+  if (!_currentTile) {
+    // Hosts able to receive the result tile by tiles spare us a full size buffer
+    _tiledSpectrum = result.spectrum();
+    _tiledOutputStarted =
+        gmic_qt_begin_tiled_output(_tiledImageSize.width(), _tiledImageSize.height(), _tiledSpectrum, *_tiledImageNames, io.outputMode, label.isEmpty() ? nullptr : label.constData());
+    if (!_tiledOutputStarted) {
+      _tiledResult->assign(_tiledImageSize.width(), _tiledImageSize.height(), 1, _tiledSpectrum);
+    }
+  }
+  if (_tiledOutputStarted) {
+    gmic_qt_output_tile(result, tile.x(), tile.y());
+  } else {
+    _tiledResult->draw_image(tile.x(), tile.y(), result);
+  }
+  result.assign();
+  if (++_currentTile < _tiles.size()) {
+    processNextTile();
+    return;
+  }
+
+  _tiles.clear();
+  hideWaitingCursor();
+  PreviewCache::clear(); // Input image is about to change
+  if (_tiledOutputStarted) {
+    _tiledOutputStarted = false;
+    gmic_qt_end_tiled_output(true);
+  } else {
+    _gmicImages->assign(1);
+    _tiledResult->move_to((*_gmicImages)[0]);
+    gmic_qt_output_images(*_gmicImages, *_tiledImageNames, io.outputMode, label.isEmpty() ? nullptr : label.constData());
+    _gmicImages->assign();
+  }
+  emit fullImageProcessingDone();
+}
+
+void GmicProcessor::abandonTiledProcessing()
+{
+  clearTiledProcessing();
+  _filterContext.tiledProcessing = false;
+  execute();
+}
+
+void GmicProcessor::clearTiledProcessing()
+{
+  if (_tiledOutputStarted) {
+    // Tiles already sent are dropped by the host
+    _tiledOutputStarted = false;
+    gmic_qt_end_tiled_output(false);
+  }
+  _tiles.clear();
+  _tiledResult->assign();
+}
+
 void GmicProcessor::onAbortedThreadFinished()
 {
   FilterThread * thread = dynamic_cast<FilterThread *>(sender());
   if (_unfinishedAbortedThreads.contains(thread)) {
     _unfinishedAbortedThreads.removeOne(thread);
-    thread->deleteLater();
+    recycleFilterThread(thread);
+  }
+  if (_unfinishedAbortedThreads.isEmpty()) {
+    _lastCancelToIdleDuration = _cancelTime.elapsed();
+    TSHOW(_lastCancelToIdleDuration);
+  }
+  if (!_filterThread && !tooManyUnfinishedAbortedThreads()) {
+    const DeferredRequest request = _deferredRequest;
+    _deferredRequest = NoDeferredRequest;
+    if (request == DeferredPreview) {
+      execute();
+    } else if (request == DeferredSpeculativePreview) {
+      _filterContext = _speculativeContext;
+      startSpeculativePreview();
+    }
   }
   if (_unfinishedAbortedThreads.isEmpty()) {
     emit noMoreUnfinishedJobs();
@@ -282,18 +705,125 @@ void GmicProcessor::updateImageNames(gmic_list<char> & imageNames)
   }
 }
 
+bool GmicProcessor::previewCoversFullImage() const
+{
+  // Same input as Apply: the whole image, neither cropped nor downscaled
+  const FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+  static const double epsilon = 1e-6;
+  return (std::abs(rect.x) < epsilon) && (std::abs(rect.y) < epsilon) && (std::abs(rect.w - 1.0) < epsilon) && (std::abs(rect.h - 1.0) < epsilon) && (_filterContext.zoomFactor >= 1.0) &&
+         (_filterContext.inputOutputState.outputMessageMode <= GmicQt::VerboseLayerName);
+}
+
+QString GmicProcessor::previewOutputKey(const QString & env) const
+{
+  return QString("%1|%2|%3|%4").arg(_filterContext.filterCommand).arg(_filterContext.filterArguments).arg(env).arg(_previewRandomSeed);
+}
+
+void GmicProcessor::clearPreviewOutput()
+{
+  _previewOutput->assign();
+  _previewOutputNames->assign();
+  _previewOutputStatus.clear();
+  _previewOutputKey.clear();
+}
+
+void GmicProcessor::outputPreviewResult()
+{
+  // Apply would run the very same command on the very same input with the same random seed
+  _gmicStatus = _previewOutputStatus;
+  PreviewCache::clear(); // Input image is about to change
+  _gmicImages->assign();
+  _gmicImages->swap(*_previewOutput);
+  if (_filterContext.inputOutputState.outputMessageMode == GmicQt::VerboseLayerName) {
+    QString label = QString("[G'MIC] %1: %2 %3").arg(_filterContext.filterName).arg(_filterContext.filterCommand).arg(_filterContext.filterArguments);
+    gmic_qt_output_images(*_gmicImages, *_previewOutputNames, _filterContext.inputOutputState.outputMode, label.toLocal8Bit().constData());
+  } else {
+    gmic_qt_output_images(*_gmicImages, *_previewOutputNames, _filterContext.inputOutputState.outputMode, 0);
+  }
+  _gmicImages->assign();
+  clearPreviewOutput();
+  emit fullImageProcessingDone();
+}
+
+QString GmicProcessor::previewCacheKey() const
+{
+  const GmicQt::InputOutputState & io = _filterContext.inputOutputState;
+  if (io.outputMessageMode > GmicQt::VerboseLayerName) {
+    return QString(); // User expects the command to actually run and log something
+  }
+  const FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+  QStringList key;
+  key << QString::number(rect.x, 'g', 17) << QString::number(rect.y, 'g', 17) << QString::number(rect.w, 'g', 17) << QString::number(rect.h, 'g', 17);
+  key << QString::number(_filterContext.positionStringCorrection.xFactor, 'g', 17) << QString::number(_filterContext.positionStringCorrection.yFactor, 'g', 17);
+  key << QString::number(_filterContext.zoomFactor, 'g', 17) << QString::number(_filterContext.previewWidth) << QString::number(_filterContext.previewHeight);
+  key << QString::number(_filterContext.previewTimeout);
+  key << QString::number(io.inputMode) << QString::number(io.outputMode) << QString::number(io.previewMode) << QString::number(io.outputMessageMode);
+  key << _filterContext.filterName << _filterContext.filterCommand << _filterContext.filterArguments;
+  return key.join(QChar(31));
+}
+
 void GmicProcessor::abortCurrentFilterThread()
 {
+  _deferredRequest = NoDeferredRequest;
   if (!_filterThread) {
     return;
   }
+  if (_unfinishedAbortedThreads.isEmpty()) {
+    _cancelTime.start();
+  }
   _filterThread->disconnect(this);
   connect(_filterThread, SIGNAL(finished()), this, SLOT(onAbortedThreadFinished()));
   _unfinishedAbortedThreads.push_back(_filterThread);
   _filterThread->abortGmic();
+  if (_filterThread->isRunning()) {
+    // Leave the CPU to the next job until G'MIC notices the abort
+    _filterThread->setPriority(QThread::IdlePriority);
+  }
   _filterThread = 0;
+  _speculating = false;
+  _speculativeRequestPending = false;
+  clearTiledProcessing();
   _waitingCursorTimer.stop();
   if (QApplication::overrideCursor() && QApplication::overrideCursor()->shape() == Qt::WaitCursor) {
     QApplication::restoreOverrideCursor();
   }
 }
+
+FilterThread * GmicProcessor::newFilterThread(const QString & environment, const char * finishedSlot)
+{
+  FilterThread * thread = nullptr;
+  for (int i = 0; i < _idleFilterThreads.size(); ++i) {
+    // finished() may be delivered before the thread has actually stopped
+    if (_idleFilterThreads[i]->isFinished()) {
+      thread = _idleFilterThreads.takeAt(i);
+      break;
+    }
+  }
+  const QString & name = _filterContext.filterName;
+  const QString & command = _filterContext.filterCommand;
+  const QString & arguments = _filterContext.filterArguments;
+  const GmicQt::OutputMessageMode mode = _filterContext.inputOutputState.outputMessageMode;
+  if (thread) {
+    thread->setup(name, command, arguments, environment, mode);
+  } else {
+    thread = new FilterThread(this, name, command, arguments, environment, mode);
+    thread->setInterpreterPool(&_interpreterPool);
+  }
+  connect(thread, SIGNAL(finished()), this, finishedSlot);
+  return thread;
+}
+
+void GmicProcessor::recycleFilterThread(FilterThread * thread)
+{
+  thread->disconnect(this);
+  if (_idleFilterThreads.size() < MAX_IDLE_FILTER_THREADS) {
+    _idleFilterThreads.push_back(thread);
+  } else {
+    thread->deleteLater();
+  }
+}
+
+bool GmicProcessor::tooManyUnfinishedAbortedThreads() const
+{
+  return _unfinishedAbortedThreads.size() >= MAX_UNFINISHED_ABORTED_THREADS;
+}
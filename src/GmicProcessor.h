@@ -25,11 +25,16 @@
 #ifndef _GMIC_QT_GMICPROCESSOR_H_
 #define _GMIC_QT_GMICPROCESSOR_H_
 
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QRect>
 #include <QSettings>
+#include <QSize>
 #include <QStringList>
+#include <QTime>
 #include <QTimer>
+#include "GmicInterpreterPool.h"
 #include "InputOutputState.h"
 #include "PreviewMode.h"
 #include "gmic_qt.h"
@@ -68,12 +73,17 @@ public:
     QString filterName;
     QString filterCommand;
     QString filterArguments;
+    bool progressivePreview;
+    bool tiledProcessing;
+    int tileSize;
+    int tileHalo;
   };
 
   GmicProcessor(QObject * parent = nullptr);
   void init();
   void setContext(const FilterContext & context);
   void execute();
+  void speculate(const FilterContext & context);
 
   bool isProcessingFullImage() const;
 
@@ -88,6 +98,7 @@ public:
 
   int duration() const;
   float progress() const;
+  int lastCancelToIdleDuration() const;
 public slots:
   void cancel();
 
@@ -95,29 +106,95 @@ signals:
   void previewCommandFailed(QString errorMessage);
   void fullImageProcessingFailed(QString errorMessage);
   void previewImageAvailable();
+  void speculativePreviewImageAvailable();
   void fullImageProcessingDone(); // TODO : Use for exemple to close the window
   void noMoreUnfinishedJobs();
 
 private slots:
   void onPreviewThreadFinished();
+  void onSpeculativeThreadFinished();
   void onApplyThreadFinished();
+  void onTileThreadFinished();
   void onAbortedThreadFinished();
   void showWaitingCursor();
   void hideWaitingCursor();
 
 private:
   void updateImageNames(cimg_library::CImgList<char> & imageNames);
+  QString previewCacheKey() const;
+  bool previewCoversFullImage() const;
+  QString previewOutputKey(const QString & env) const;
+  void clearPreviewOutput();
+  void outputPreviewResult();
+  int firstPreviewStage() const;
+  static double previewStageScale(int stage);
+  void startPreviewStage();
+  QString previewEnvironment(const QString & env, double scale) const;
+  QString speculativeInputKey() const;
+  void startSpeculativePreview();
+  QString environment() const;
+  bool shouldProcessByTiles() const;
+  void startTiledProcessing();
+  void processNextTile();
+  void abandonTiledProcessing();
+  void clearTiledProcessing();
   void abortCurrentFilterThread();
+  FilterThread * newFilterThread(const QString & environment, const char * finishedSlot);
+  void recycleFilterThread(FilterThread * thread);
+  bool tooManyUnfinishedAbortedThreads() const;
+  enum DeferredRequest
+  {
+    NoDeferredRequest,
+    DeferredPreview,
+    DeferredSpeculativePreview
+  };
 
   FilterThread * _filterThread;
   FilterContext _filterContext;
   cimg_library::CImgList<float> * _gmicImages;
   cimg_library::CImg<float> * _previewImage;
+  cimg_library::CImgList<float> * _previewInput;
+  cimg_library::CImgList<char> * _previewImageNames;
+  QString _previewEnvironment;
+  cimg_library::CImgList<float> * _previewOutput; // Raw output of a full image preview, reusable by Apply
+  cimg_library::CImgList<char> * _previewOutputNames;
+  QStringList _previewOutputStatus;
+  QString _previewOutputKey;
+  int _previewStage;
+  QHash<QString, int> _previewDurations; // Last full preview duration (ms) of each command
+  bool _speculating;
+  bool _speculativeRequestPending;
+  FilterContext _speculativeContext;
+  cimg_library::CImgList<float> * _speculativeInput;
+  cimg_library::CImgList<char> * _speculativeImageNames;
+  QString _speculativeInputKey;
+  QList<QRect> _tiles;
+  int _currentTile;
+  QSize _tiledImageSize;
+  cimg_library::CImg<float> * _tiledResult; // Stitched result, for hosts without tiled output
+  int _tiledSpectrum;
+  bool _tiledOutputStarted;
+  cimg_library::CImgList<char> * _tiledImageNames;
+  QTime _tiledProcessingTime;
   QList<FilterThread *> _unfinishedAbortedThreads;
+  QList<FilterThread *> _idleFilterThreads;
+  DeferredRequest _deferredRequest;
+  QTime _cancelTime;
+  int _lastCancelToIdleDuration; // Time (ms) from a cancellation to the end of all aborted threads
+  GmicInterpreterPool _interpreterPool;
   unsigned int _previewRandomSeed;
+  QString _previewCacheKey;
   QStringList _gmicStatus;
   QTimer _waitingCursorTimer;
   static const int WAITING_CURSOR_DELAY = 200;
+  static const int MAX_IDLE_FILTER_THREADS = 2;
+  static const int MAX_UNFINISHED_ABORTED_THREADS = 2; // Previews wait above this count
+
+  // Progressive preview runs stages at 1/4, 1/2 and full preview size
+  // Speculative previews (while a slider is dragged) run at the first stage size
+  static const int LAST_PREVIEW_STAGE = 2;
+  static const int PROGRESSIVE_PREVIEW_MIN_DURATION = 200;
+  static const unsigned long PROGRESSIVE_PREVIEW_MIN_PIXELS = 256 * 256;
 
   QString _lastAppliedFilterName;
   QString _lastAppliedCommand;
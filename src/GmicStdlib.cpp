@@ -25,15 +25,75 @@
 #include "GmicStdlib.h"
 #include <QDebug>
 #include <QFile>
+#include <QHash>
 #include <QList>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <cstring>
 #include "Common.h"
 #include "Utils.h"
 #include "gmic.h"
 
 QByteArray GmicStdLib::Array;
 
+namespace
+{
+QByteArray indexedStdlib;                  // Shares its data with the indexed GmicStdLib::Array
+QHash<QByteArray, QByteArray> definitions; // Command name -> definition
+QHash<QByteArray, bool> mentionsCache;
+
+bool isNameStart(char c)
+{
+  return (c == '_') || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
+
+bool isNameChar(char c)
+{
+  return isNameStart(c) || ((c >= '0') && (c <= '9'));
+}
+
+// Definitions start with "name :" at the beginning of a line
+void indexDefinitions()
+{
+  if ((indexedStdlib.constData() == GmicStdLib::Array.constData()) && (indexedStdlib.size() == GmicStdLib::Array.size())) {
+    return;
+  }
+  indexedStdlib = GmicStdLib::Array;
+  definitions.clear();
+  mentionsCache.clear();
+  const char * const data = indexedStdlib.constData();
+  const char * const end = data + indexedStdlib.size();
+  QByteArray * definition = nullptr;
+  for (const char * line = data; line < end;) {
+    const char * eol = static_cast<const char *>(std::memchr(line, '\n', end - line));
+    if (!eol) {
+      eol = end;
+    }
+    if ((line < eol) && (*line != '#')) {
+      const char * p = line;
+      if (isNameStart(*p)) {
+        while ((p < eol) && isNameChar(*p)) {
+          ++p;
+        }
+        const char * name = p;
+        while ((p < eol) && (*p == ' ')) {
+          ++p;
+        }
+        if ((p < eol) && (*p == ':') && ((p + 1 == eol) || (p[1] != '='))) {
+          definition = &definitions[QByteArray(line, static_cast<int>(name - line))];
+          line = p + 1;
+        }
+      }
+      if (definition) {
+        definition->append(line, static_cast<int>(eol - line)).append('\n');
+      }
+    }
+    line = eol + 1;
+  }
+}
+}
+
 void GmicStdLib::loadStdLib()
 {
   QFile stdlib(QString("%1update%2.gmic").arg(GmicQt::path_rc(false)).arg(gmic_version));
@@ -45,3 +105,51 @@ void GmicStdLib::loadStdLib()
     Array = stdlib.readAll();
   }
 }
+
+bool GmicStdLib::commandMentions(const QString & command, const QList<QByteArray> & variables)
+{
+  indexDefinitions();
+  QByteArray name = command.trimmed().toUtf8();
+  while (name.startsWith('-') || name.startsWith('+')) {
+    name.remove(0, 1);
+  }
+  QByteArray key = name;
+  for (const QByteArray & variable : variables) {
+    key += ' ' + variable;
+  }
+  QHash<QByteArray, bool>::const_iterator cached = mentionsCache.constFind(key);
+  if (cached != mentionsCache.constEnd()) {
+    return cached.value();
+  }
+  bool mentions = !definitions.contains(name);
+  QSet<QByteArray> visited;
+  QList<QByteArray> pending;
+  visited.insert(name);
+  pending.push_back(name);
+  while (!mentions && !pending.isEmpty()) {
+    const QByteArray definition = definitions.value(pending.takeLast());
+    for (const QByteArray & variable : variables) {
+      mentions = mentions || definition.contains(variable);
+    }
+    // Any word naming a stdlib command may be a call
+    const char * p = definition.constData();
+    const char * const end = p + definition.size();
+    while (p < end) {
+      if (!isNameStart(*p)) {
+        ++p;
+        continue;
+      }
+      const char * word = p;
+      while ((p < end) && isNameChar(*p)) {
+        ++p;
+      }
+      const QByteArray callee = QByteArray::fromRawData(word, static_cast<int>(p - word));
+      if (definitions.contains(callee) && !visited.contains(callee)) {
+        visited.insert(QByteArray(word, static_cast<int>(p - word)));
+        pending.push_back(QByteArray(word, static_cast<int>(p - word)));
+      }
+    }
+  }
+  mentionsCache.insert(key, mentions);
+  return mentions;
+}
@@ -26,11 +26,18 @@
 #define _GMIC_QT_GMICSTDLIB_H_
 
 #include <QByteArray>
+#include <QList>
 
 class GmicStdLib {
 public:
   GmicStdLib() = delete;
   static void loadStdLib();
+  /**
+   * @brief Whether the definition of a command of the stdlib, or of a stdlib
+   *        command it may call, mentions one of the given variables.
+   *        Commands not defined in the stdlib are assumed to mention them.
+   */
+  static bool commandMentions(const QString & command, const QList<QByteArray> & variables);
   static QByteArray Array;
 };
 
@@ -90,6 +90,7 @@ void HeadlessProcessor::startProcessing()
     gmic_qt_show_message(QString("G'MIC: %1").arg(_lastArguments).toUtf8().constData());
   }
   _filterThread = new FilterThread(this, _filterName, _lastCommand, _lastArguments, _lastEnvironment, _outputMessageMode);
+  _filterThread->setInterpreterPool(&_interpreterPool);
   _filterThread->swapImages(*_gmicImages);
   _filterThread->setImageNames(imageNames);
 
@@ -28,6 +28,7 @@
 #include <QObject>
 #include <QString>
 #include <QTimer>
+#include "GmicInterpreterPool.h"
 #include "gmic_qt.h"
 
 class FilterThread;
@@ -74,6 +75,7 @@ signals:
 private:
   FilterThread * _filterThread;
   cimg_library::CImgList<float> * _gmicImages;
+  GmicInterpreterPool _interpreterPool;
   QTimer _timer;
   QString _filterName;
   QString _lastCommand;
@@ -0,0 +1,96 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BandTransfer.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_BANDTRANSFER_H_
+#define _GMIC_QT_BANDTRANSFER_H_
+
+#include <algorithm>
+#include "gmic.h"
+
+/**
+ * Transfer of images between the G'MIC planar layout, with values in
+ * [0,255], and an interleaved buffer with values in [0,1], one band of rows
+ * at a time: no full-size temporary image is needed. The GIMP host reads and
+ * writes the bands with gegl_buffer_get/set, the benchmarks with a stand-in.
+ */
+namespace BandTransfer
+{
+// Pixels transferred per band
+const int DefaultBandPixels = 256 * 1024;
+
+inline int bandRows(int width, int bandPixels)
+{
+  return std::max(1, bandPixels / std::max(1, width));
+}
+
+/**
+ * @brief Read a width x height image into img, band by band.
+ * @param get Called as get(y, rows, data) to read rows [y, y + rows) into
+ *            data, interleaved
+ */
+template <typename Get> void read(int width, int height, int spectrum, Get get, cimg_library::CImg<float> & img, int bandPixels = DefaultBandPixels)
+{
+  img.assign(width, height, 1, spectrum);
+  const int rowsPerBand = bandRows(width, bandPixels);
+  cimg_library::CImg<float> band(spectrum * width * std::min(rowsPerBand, height));
+  for (int y0 = 0; y0 < height; y0 += rowsPerBand) {
+    const int rows = std::min(rowsPerBand, height - y0);
+    get(y0, rows, band.data());
+    for (int c = 0; c < spectrum; ++c) {
+      const float * src = band.data() + c;
+      float * dst = img.data(0, y0, 0, c);
+      for (int n = width * rows; n; --n, src += spectrum) {
+        *dst++ = 255 * *src;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Write img band by band.
+ * @param set Called as set(y, rows, data) to write rows [y, y + rows) from
+ *            data, interleaved
+ */
+template <typename Set> void write(const cimg_library::CImg<float> & img, Set set, int bandPixels = DefaultBandPixels)
+{
+  const int width = img.width();
+  const int height = img.height();
+  const int spectrum = img.spectrum();
+  const int rowsPerBand = bandRows(width, bandPixels);
+  cimg_library::CImg<float> band(spectrum * width * std::min(rowsPerBand, height));
+  for (int y0 = 0; y0 < height; y0 += rowsPerBand) {
+    const int rows = std::min(rowsPerBand, height - y0);
+    for (int c = 0; c < spectrum; ++c) {
+      const float * src = img.data(0, y0, 0, c);
+      float * dst = band.data() + c;
+      for (int n = width * rows; n; --n, dst += spectrum) {
+        *dst = *src++ / 255;
+      }
+    }
+    set(y0, rows, band.data());
+  }
+}
+}
+
+#endif // _GMIC_QT_BANDTRANSFER_H_
@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <limits>
 #include "Common.h"
+#include "Host/Gimp/BandTransfer.h"
 #include "Host/host.h"
 #include "ImageTools.h"
 #include "gmic_qt.h"
@@ -225,6 +226,52 @@ void get_output_layer_props(const char * const s, GimpLayerModeEffects & blendmo
     }
   }
 }
+
+#if !((GIMP_MAJOR_VERSION < 2) || ((GIMP_MAJOR_VERSION == 2) && (GIMP_MINOR_VERSION <= 8)))
+
+// Reads bands of rows of a rectangle of a GEGL buffer
+struct GeglBandReader {
+  GeglBuffer * buffer;
+  GeglRectangle rect;
+  const Babl * format;
+  void operator()(int y, int rows, float * data) const
+  {
+    GeglRectangle band;
+    gegl_rectangle_set(&band, rect.x, rect.y + y, rect.width, rows);
+    gegl_buffer_get(buffer, &band, 1, format, data, 0, GEGL_ABYSS_NONE);
+  }
+};
+
+// Writes bands of rows of an image into a GEGL buffer, at (x,y)
+struct GeglBandWriter {
+  GeglBuffer * buffer;
+  int x;
+  int y;
+  int width;
+  const Babl * format;
+  void operator()(int y0, int rows, const float * data) const
+  {
+    GeglRectangle band;
+    gegl_rectangle_set(&band, x, y + y0, width, rows);
+    gegl_buffer_set(buffer, &band, 0, format, data, 0);
+  }
+};
+
+// Read the rectangle rect of buffer into img (planar, values in [0,255])
+void getImageFromGeglBuffer(GeglBuffer * buffer, const GeglRectangle & rect, const char * const format, int spectrum, cimg_library::CImg<float> & img)
+{
+  const GeglBandReader reader = {buffer, rect, babl_format(format)};
+  BandTransfer::read(rect.width, rect.height, spectrum, reader, img);
+}
+
+// Write img (planar, values in [0,255]) into buffer, with its top-left corner at (x,y)
+void setGeglBufferFromImage(GeglBuffer * buffer, int x, int y, const char * const format, const cimg_library::CImg<float> & img)
+{
+  const GeglBandWriter writer = {buffer, x, y, img.width(), babl_format(format)};
+  BandTransfer::write(img, writer);
+}
+
+#endif
 }
 
 void gmic_qt_show_message(const char * message)
@@ -513,9 +560,8 @@ void gmic_qt_get_cropped_images(gmic_list<float> & images, gmic_list<char> & ima
     gegl_rectangle_set(&rect, ix, iy, iw, ih);
     GeglBuffer * buffer = gimp_drawable_get_buffer(inputLayers[l]);
     const char * const format = spectrum == 1 ? "Y' " gmic_pixel_type_str : spectrum == 2 ? "Y'A " gmic_pixel_type_str : spectrum == 3 ? "R'G'B' " gmic_pixel_type_str : "R'G'B'A " gmic_pixel_type_str;
-    CImg<float> img(spectrum, iw, ih);
-    gegl_buffer_get(buffer, &rect, 1, babl_format(format), img.data(), 0, GEGL_ABYSS_NONE);
-    (img *= 255).permute_axes("yzcx");
+    CImg<float> img;
+    getImageFromGeglBuffer(buffer, rect, format, spectrum, img);
     g_object_unref(buffer);
 #endif
     img.move_to(images[l]);
@@ -617,8 +663,7 @@ void gmic_qt_output_images(gmic_list<gmic_pixel_type> & images, const gmic_list<
           gegl_rectangle_set(&rect, rgn_x, rgn_y, rgn_width, rgn_height);
           GeglBuffer * buffer = gimp_drawable_get_shadow_buffer(inputLayers[p]);
           const char * const format = img.spectrum() == 1 ? "Y' float" : img.spectrum() == 2 ? "Y'A float" : img.spectrum() == 3 ? "R'G'B' float" : "R'G'B'A float";
-          (img /= 255).permute_axes("cxyz");
-          gegl_buffer_set(buffer, &rect, 0, babl_format(format), img.data(), 0);
+          setGeglBufferFromImage(buffer, rect.x, rect.y, format, img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(inputLayers[p], true);
           gimp_drawable_update(inputLayers[p], 0, 0, img.width(), img.height());
@@ -693,8 +738,7 @@ void gmic_qt_output_images(gmic_list<gmic_pixel_type> & images, const gmic_list<
 #else
           GeglBuffer * buffer = gimp_drawable_get_shadow_buffer(layer_id);
           const char * const format = img.spectrum() == 1 ? "Y' float" : img.spectrum() == 2 ? "Y'A float" : img.spectrum() == 3 ? "R'G'B' float" : "R'G'B'A float";
-          (img /= 255).permute_axes("cxyz");
-          gegl_buffer_set(buffer, NULL, 0, babl_format(format), img.data(), 0);
+          setGeglBufferFromImage(buffer, 0, 0, format, img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id, true);
           gimp_drawable_update(layer_id, 0, 0, img.width(), img.height());
@@ -771,8 +815,7 @@ void gmic_qt_output_images(gmic_list<gmic_pixel_type> & images, const gmic_list<
 #else
           GeglBuffer * buffer = gimp_drawable_get_shadow_buffer(layer_id);
           const char * const format = img.spectrum() == 1 ? "Y' float" : img.spectrum() == 2 ? "Y'A float" : img.spectrum() == 3 ? "R'G'B' float" : "R'G'B'A float";
-          (img /= 255).permute_axes("cxyz");
-          gegl_buffer_set(buffer, NULL, 0, babl_format(format), img.data(), 0);
+          setGeglBufferFromImage(buffer, 0, 0, format, img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id, true);
           gimp_drawable_update(layer_id, 0, 0, img.width(), img.height());
@@ -849,8 +892,7 @@ void gmic_qt_output_images(gmic_list<gmic_pixel_type> & images, const gmic_list<
 #else
           GeglBuffer * buffer = gimp_drawable_get_shadow_buffer(layer_id);
           const char * const format = img.spectrum() == 1 ? "Y' float" : img.spectrum() == 2 ? "Y'A float" : img.spectrum() == 3 ? "R'G'B' float" : "R'G'B'A float";
-          (img /= 255).permute_axes("cxyz");
-          gegl_buffer_set(buffer, NULL, 0, babl_format(format), img.data(), 0);
+          setGeglBufferFromImage(buffer, 0, 0, format, img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id, true);
           gimp_drawable_update(layer_id, 0, 0, img.width(), img.height());
@@ -866,6 +908,98 @@ void gmic_qt_output_images(gmic_list<gmic_pixel_type> & images, const gmic_list<
   gimp_displays_flush();
 }
 
+#if !((GIMP_MAJOR_VERSION < 2) || ((GIMP_MAJOR_VERSION == 2) && (GIMP_MINOR_VERSION <= 8)))
+namespace
+{
+// Target of a tiled output: the shadow buffer of the single input layer
+GeglBuffer * tiledOutputBuffer = 0;
+const char * tiledOutputFormat = 0;
+GimpLayerModeEffects tiledOutputBlendMode = GIMP_NORMAL_MODE;
+double tiledOutputOpacity = 100;
+gint tiledOutputPosX = 0, tiledOutputPosY = 0;
+cimg_library::CImg<char> tiledOutputName;
+}
+#endif
+
+bool gmic_qt_begin_tiled_output(int width, int height, int spectrum, const gmic_list<char> & imageNames, GmicQt::OutputMode outputMode, const char * verboseLayersLabel)
+{
+#if (GIMP_MAJOR_VERSION < 2) || ((GIMP_MAJOR_VERSION == 2) && (GIMP_MINOR_VERSION <= 8))
+  unused(imageNames);
+  unused(width, height, spectrum, outputMode, verboseLayersLabel);
+  return false;
+#else
+  // Only the in place replacement of a single layer, without selection, is done by
+  // tiles: the shadow buffer of the layer then receives each tile as it comes.
+  int is_selection = 0, sel_x0 = 0, sel_y0 = 0, sel_x1 = 0, sel_y1 = 0;
+  if (outputMode != GmicQt::InPlace || inputLayers.size() != 1 || imageNames.size() != 1 || width != inputLayerDimensions(0, 0) || height != inputLayerDimensions(0, 1) ||
+      (gimp_selection_bounds(gmic_qt_gimp_image_id, &is_selection, &sel_x0, &sel_y0, &sel_x1, &sel_y1) && is_selection)) {
+    return false;
+  }
+  const bool source_is_alpha = (inputLayerDimensions(0, 3) == 2 || inputLayerDimensions(0, 3) >= 4);
+  const bool dest_is_alpha = (spectrum == 2 || spectrum >= 4);
+  if (dest_is_alpha && !source_is_alpha) {
+    gimp_layer_add_alpha(inputLayers[0]);
+    ++inputLayerDimensions(0, 3);
+  }
+  gimp_image_undo_group_start(gmic_qt_gimp_image_id);
+  tiledOutputBlendMode = gimp_layer_get_mode(inputLayers[0]);
+  tiledOutputOpacity = gimp_layer_get_opacity(inputLayers[0]);
+  gimp_drawable_offsets(inputLayers[0], &tiledOutputPosX, &tiledOutputPosY);
+  cimg_library::CImg<char>::string(gimp_item_get_name(inputLayers[0])).move_to(tiledOutputName);
+  get_output_layer_props(imageNames[0], tiledOutputBlendMode, tiledOutputOpacity, tiledOutputPosX, tiledOutputPosY, tiledOutputName);
+  if (verboseLayersLabel) {
+    cimg_library::CImg<char>::string(verboseLayersLabel).move_to(tiledOutputName);
+  }
+  const int channels = inputLayerDimensions(0, 3);
+  tiledOutputFormat = channels == 1 ? "Y' float" : channels == 2 ? "Y'A float" : channels == 3 ? "R'G'B' float" : "R'G'B'A float";
+  tiledOutputBuffer = gimp_drawable_get_shadow_buffer(inputLayers[0]);
+  return true;
+#endif
+}
+
+void gmic_qt_output_tile(cimg_library::CImg<gmic_pixel_type> & tile, int x, int y)
+{
+#if (GIMP_MAJOR_VERSION < 2) || ((GIMP_MAJOR_VERSION == 2) && (GIMP_MINOR_VERSION <= 8))
+  unused(tile);
+  unused(x, y);
+#else
+  if (!tiledOutputBuffer) {
+    return;
+  }
+  GmicQt::calibrate_image(tile, inputLayerDimensions(0, 3), false);
+  setGeglBufferFromImage(tiledOutputBuffer, x, y, tiledOutputFormat, tile);
+  tile.assign();
+#endif
+}
+
+void gmic_qt_end_tiled_output(bool commit)
+{
+#if (GIMP_MAJOR_VERSION < 2) || ((GIMP_MAJOR_VERSION == 2) && (GIMP_MINOR_VERSION <= 8))
+  unused(commit);
+#else
+  if (!tiledOutputBuffer) {
+    return;
+  }
+  g_object_unref(tiledOutputBuffer);
+  tiledOutputBuffer = 0;
+  if (commit) {
+    gimp_drawable_merge_shadow(inputLayers[0], true);
+    gimp_drawable_update(inputLayers[0], 0, 0, inputLayerDimensions(0, 0), inputLayerDimensions(0, 1));
+    gimp_layer_set_mode(inputLayers[0], tiledOutputBlendMode);
+    gimp_layer_set_opacity(inputLayers[0], tiledOutputOpacity);
+    gimp_layer_set_offsets(inputLayers[0], tiledOutputPosX, tiledOutputPosY);
+    if (tiledOutputName) {
+      gimp_item_set_name(inputLayers[0], tiledOutputName);
+    }
+  } else {
+    gimp_drawable_free_shadow(inputLayers[0]);
+  }
+  tiledOutputName.assign();
+  gimp_image_undo_group_end(gmic_qt_gimp_image_id);
+  gimp_displays_flush();
+#endif
+}
+
 /*
  * 'Run' function, required by the GIMP plug-in API.
  */
@@ -0,0 +1,378 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KritaClient.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "Host/Krita/KritaClient.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QList>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QUuid>
+#include <QtEndian>
+#include <cstring>
+#include "gmic.h"
+
+const char * KritaClient::HelloMessage = "command=gmic_qt_hello\nprotocol=2";
+
+namespace
+{
+const char Ack[] = "ack";
+
+struct LayerDescriptor {
+  QByteArray key;
+  QByteArray name;
+  qint32 width;
+  qint32 height;
+  qint32 spectrum;
+};
+
+// Wait until count bytes are available, as long as the socket is connected
+bool waitForBytes(QLocalSocket & socket, qint64 count)
+{
+  while (socket.bytesAvailable() < count) {
+    if (!socket.waitForReadyRead(1000) && (socket.state() != QLocalSocket::ConnectedState)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool readUInt32(QLocalSocket & socket, quint32 & value)
+{
+  uchar bytes[sizeof(quint32)];
+  if (!waitForBytes(socket, sizeof(bytes)) || (socket.read(reinterpret_cast<char *>(bytes), sizeof(bytes)) != sizeof(bytes))) {
+    return false;
+  }
+  value = qFromBigEndian<quint32>(bytes);
+  return true;
+}
+
+// Read what QDataStream::writeBytes() wrote
+bool readBytes(QLocalSocket & socket, QByteArray & data)
+{
+  quint32 length;
+  if (!readUInt32(socket, length) || !waitForBytes(socket, length)) {
+    return false;
+  }
+  data = socket.read(length);
+  return data.size() == static_cast<int>(length);
+}
+}
+
+KritaClient::KritaClient(const QString & socketKey) : _socketKey(socketKey), _protocol(0), _session(nullptr), _nextId(1) {}
+
+KritaClient::~KritaClient()
+{
+  close();
+  releaseOutputSegments();
+}
+
+int KritaClient::protocol()
+{
+  if (!_protocol) {
+    negotiate();
+  }
+  return _protocol;
+}
+
+QByteArray KritaClient::request(const QByteArray & message)
+{
+  QByteArray answer;
+  if (protocol() == 2) {
+    const quint32 id = _nextId++;
+    if (writeFrame(id, message)) {
+      if (!readAnswer(id, answer)) {
+        // The request may have been served: do not send it again
+        qWarning() << "gmic-qt: Lost the session with Krita.";
+        close();
+        _protocol = 1;
+      }
+      return answer;
+    }
+    close();
+    _protocol = 1;
+  }
+  QLocalSocket socket;
+  exchange(socket, message, answer);
+  socket.disconnectFromServer();
+  return answer;
+}
+
+void KritaClient::post(const QByteArray & message)
+{
+  if (protocol() == 2) {
+    const quint32 id = _nextId++;
+    if (writeFrame(id, message)) {
+      _postedIds.insert(id);
+      return;
+    }
+    close();
+    _protocol = 1;
+  }
+  request(message);
+}
+
+bool KritaClient::getLayersExtent(int mode, int & width, int & height)
+{
+  width = 0;
+  height = 0;
+  const QByteArray answer = request(QString("command=gmic_qt_get_image_size\nmode=%1").arg(mode).toUtf8());
+  if (answer.isEmpty()) {
+    return false;
+  }
+  if (_protocol == 2) {
+    QDataStream in(answer);
+    qint32 w, h;
+    in >> w >> h;
+    if (in.status() != QDataStream::Ok) {
+      return false;
+    }
+    width = w;
+    height = h;
+    return true;
+  }
+  const QList<QByteArray> wh = answer.split(',');
+  if (wh.length() != 2) {
+    return false;
+  }
+  width = wh[0].toInt();
+  height = wh[1].toInt();
+  return true;
+}
+
+bool KritaClient::getCroppedImages(int mode, double x, double y, double width, double height, gmic_list<float> & images, gmic_list<char> & imageNames)
+{
+  const QByteArray answer = request(QString("command=gmic_qt_get_cropped_images\nmode=%5\ncroprect=%1,%2,%3,%4").arg(x).arg(y).arg(width).arg(height).arg(mode).toUtf8());
+  if (answer.isEmpty()) {
+    qWarning() << "\tgmic-qt: empty answer!";
+    return false;
+  }
+
+  bool ok = true;
+  QList<LayerDescriptor> layers;
+  if (_protocol == 2) {
+    QDataStream in(answer);
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+      LayerDescriptor layer;
+      in >> layer.key >> layer.name >> layer.width >> layer.height >> layer.spectrum;
+      layers.push_back(layer);
+    }
+    if (in.status() != QDataStream::Ok) {
+      qWarning() << "\tgmic-qt: Got the wrong answer!";
+      layers.clear();
+      ok = false;
+    }
+  } else {
+    // The answer is plain ASCII (names are hex-encoded): parse the bytes directly
+    QList<QByteArray> lines = answer.split('\n');
+    lines.removeAll(QByteArray());
+    for (const QByteArray & line : lines) {
+      const QList<QByteArray> parts = line.split(',');
+      LayerDescriptor layer = {QByteArray(), QByteArray(), 0, 0, 4};
+      if (parts.size() == 4) {
+        layer.key = parts[0];
+        layer.name = QByteArray::fromHex(parts[1]);
+        layer.width = parts[2].toInt();
+        layer.height = parts[3].toInt();
+      } else {
+        qWarning() << "\tgmic-qt: Got the wrong answer!";
+        ok = false;
+      }
+      layers.push_back(layer);
+    }
+  }
+
+  images.assign(layers.size());
+  imageNames.assign(layers.size());
+  for (int i = 0; i < layers.size(); ++i) {
+    const LayerDescriptor & layer = layers[i];
+    gmic_image<char>::string(layer.name.constData()).move_to(imageNames[i]);
+    if (layer.key.isEmpty()) {
+      continue;
+    }
+    QSharedMemory m(QString::fromLatin1(layer.key));
+    if (!m.attach(QSharedMemory::ReadOnly)) {
+      qWarning() << "\tgmic-qt: Could not attach to shared memory area." << m.error() << m.errorString();
+      ok = false;
+      continue;
+    }
+    if (!m.lock()) {
+      qWarning() << "\tgmic-qt: Could not lock memeory segment" << m.error() << m.errorString();
+    }
+    // Copy the data straight into the image of the list: G'MIC needs buffers it
+    // owns and may reallocate, so this single copy cannot be avoided.
+    const size_t bytes = static_cast<size_t>(layer.width) * layer.height * layer.spectrum * sizeof(float);
+    if (static_cast<size_t>(m.size()) < bytes) {
+      qWarning() << "\tgmic-qt: Memory segment is too small" << m.size() << bytes;
+      ok = false;
+    } else {
+      images[i].assign(layer.width, layer.height, 1, layer.spectrum);
+      std::memcpy(images[i]._data, m.constData(), bytes);
+    }
+    if (!m.unlock()) {
+      qWarning() << "\tgmic-qt: Could not unlock memeory segment" << m.error() << m.errorString();
+    }
+    if (!m.detach()) {
+      qWarning() << "\tgmic-qt: Could not detach from memeory segment" << m.error() << m.errorString();
+    }
+  }
+
+  // Its answer is read with the next request, or never
+  post("command=gmic_qt_detach");
+  return ok;
+}
+
+bool KritaClient::outputImages(const gmic_list<float> & images, const gmic_list<char> & imageNames, int mode)
+{
+  releaseOutputSegments();
+  QByteArray message = QString("command=gmic_qt_output_images\nmode=%1\n").arg(mode).toUtf8();
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    // No intermediate copy: the result is written once, into the segment read by Krita
+    const gmic_image<float> & image = images[i];
+    const size_t bytes = static_cast<size_t>(image._width) * image._height * image._spectrum * sizeof(float);
+    QSharedMemory * m = createOutputSegment(bytes);
+    if (!m) {
+      return false;
+    }
+    m->lock();
+    std::memcpy(m->data(), image._data, bytes);
+    m->unlock();
+    message += outputLayerLine(*m, QByteArray((const char *)imageNames[i]), image._spectrum, image._width, image._height);
+  }
+  request(message);
+  return true;
+}
+
+QSharedMemory * KritaClient::createOutputSegment(size_t bytes)
+{
+  QSharedMemory * m = new QSharedMemory(QString("key_%1").arg(QUuid::createUuid().toString()));
+  if (!m->create(bytes)) {
+    qWarning() << "Could not create shared memory" << m->error() << m->errorString();
+    delete m;
+    return nullptr;
+  }
+  _outputSegments.push_back(m);
+  return m;
+}
+
+void KritaClient::releaseOutputSegments()
+{
+  for (QSharedMemory * m : _outputSegments) {
+    if (m->isAttached()) {
+      m->detach();
+    }
+  }
+  qDeleteAll(_outputSegments);
+  _outputSegments.clear();
+}
+
+QByteArray KritaClient::outputLayerLine(const QSharedMemory & segment, const QByteArray & name, int spectrum, int width, int height)
+{
+  return "layer=" + segment.key().toUtf8() + "," + name.toHex() + "," + QByteArray::number(spectrum) + "," + QByteArray::number(width) + "," + QByteArray::number(height) + "\n";
+}
+
+void KritaClient::close()
+{
+  if (_session) {
+    _session->disconnectFromServer();
+    delete _session;
+    _session = nullptr;
+  }
+  _postedIds.clear();
+  _protocol = 0;
+}
+
+bool KritaClient::negotiate()
+{
+  _protocol = 1;
+  QLocalSocket * socket = new QLocalSocket;
+  QByteArray answer;
+  if (exchange(*socket, HelloMessage, answer) && (answer == "protocol=2")) {
+    _session = socket;
+    _protocol = 2;
+    return true;
+  }
+  socket->disconnectFromServer();
+  delete socket;
+  return false;
+}
+
+bool KritaClient::exchange(QLocalSocket & socket, const QByteArray & message, QByteArray & answer)
+{
+  socket.connectToServer(_socketKey);
+  if (!socket.waitForConnected(1000)) {
+    qWarning() << "Could not connect to the Krita instance.";
+    return false;
+  }
+  QDataStream ds(&socket);
+  ds.writeBytes(message.constData(), message.length());
+  socket.waitForBytesWritten();
+  if (!readBytes(socket, answer)) {
+    qWarning() << "Could not receive the answer." << socket.errorString();
+    return false;
+  }
+  // Acknowledge receipt
+  socket.write(Ack, qstrlen(Ack));
+  socket.waitForBytesWritten(1000);
+  return true;
+}
+
+bool KritaClient::writeFrame(quint32 id, const QByteArray & payload)
+{
+  if (!_session || (_session->state() != QLocalSocket::ConnectedState)) {
+    return false;
+  }
+  QByteArray frame;
+  QDataStream out(&frame, QIODevice::WriteOnly);
+  out << id;
+  out.writeBytes(payload.constData(), payload.length());
+  if (_session->write(frame) != frame.size()) {
+    return false;
+  }
+  _session->waitForBytesWritten(1000);
+  return true;
+}
+
+bool KritaClient::readFrame(quint32 & id, QByteArray & payload)
+{
+  return readUInt32(*_session, id) && readBytes(*_session, payload);
+}
+
+bool KritaClient::readAnswer(quint32 id, QByteArray & answer)
+{
+  quint32 answerId;
+  QByteArray payload;
+  while (readFrame(answerId, payload)) {
+    if (answerId == id) {
+      answer = payload;
+      return true;
+    }
+    if (!_postedIds.remove(answerId)) {
+      qWarning() << "gmic-qt: Unexpected answer from Krita" << answerId;
+    }
+  }
+  return false;
+}
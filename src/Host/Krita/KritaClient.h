@@ -0,0 +1,121 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KritaClient.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_KRITACLIENT_H_
+#define _GMIC_QT_KRITACLIENT_H_
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class QLocalSocket;
+class QSharedMemory;
+namespace cimg_library
+{
+template <typename T> struct CImgList;
+}
+
+/**
+ * @brief Client side of the local socket channel to Krita.
+ *
+ * Protocol 1 (every Krita version): one message per connection. The request
+ * and the answer are written with QDataStream::writeBytes(), the client then
+ * writes "ack" and disconnects. Answers are text, with hex-encoded names.
+ *
+ * Protocol 2 is negotiated once with the protocol 1 message
+ * "command=gmic_qt_hello\nprotocol=2". A server answering "protocol=2" keeps
+ * this connection open as a session after the "ack"; servers not knowing the
+ * command answer something else, and the client sticks to protocol 1.
+ * In a session, frames are a quint32 request id followed by the
+ * QDataStream::writeBytes() payload, in both directions. Requests may be
+ * pipelined: answers come back in request order, with the id of their request.
+ * Answers describing images are binary (see getCroppedImages()).
+ */
+class KritaClient {
+public:
+  KritaClient(const QString & socketKey);
+  ~KritaClient();
+  int protocol();
+  /**
+   * @brief Send a request and wait for its answer (empty on failure).
+   */
+  QByteArray request(const QByteArray & message);
+  /**
+   * @brief Send a request whose answer is not needed. In a session, this
+   *        returns without waiting for the answer.
+   */
+  void post(const QByteArray & message);
+  bool getLayersExtent(int mode, int & width, int & height);
+  /**
+   * @brief Fetch the layers for the given input mode, cropped to a rectangle
+   *        given in fractions of the layers extent, then release Krita's
+   *        shared memory segments.
+   *
+   * The protocol 2 answer is a QDataStream with a quint32 layer count, then
+   * for each layer the QByteArray key of its segment, its QByteArray name,
+   * and its qint32 width, height and spectrum.
+   */
+  bool getCroppedImages(int mode, double x, double y, double width, double height, cimg_library::CImgList<float> & images, cimg_library::CImgList<char> & imageNames);
+  /**
+   * @brief Copy the images into new output segments, then send their
+   *        descriptions to Krita and wait until it has read them.
+   */
+  bool outputImages(const cimg_library::CImgList<float> & images, const cimg_library::CImgList<char> & imageNames, int mode);
+  /**
+   * @brief Create a shared memory segment read by Krita, kept until the
+   *        output segments are released.
+   * @return nullptr on failure
+   */
+  QSharedMemory * createOutputSegment(size_t bytes);
+  void releaseOutputSegments();
+  /**
+   * @brief The "layer=" line describing an output segment in a
+   *        gmic_qt_output_images message.
+   */
+  static QByteArray outputLayerLine(const QSharedMemory & segment, const QByteArray & name, int spectrum, int width, int height);
+  /**
+   * @brief Close the session, if any. The protocol is negotiated again with
+   *        the next request.
+   */
+  void close();
+
+  static const int Protocol = 2;
+  static const char * HelloMessage;
+
+private:
+  bool negotiate();
+  bool exchange(QLocalSocket & socket, const QByteArray & message, QByteArray & answer);
+  bool writeFrame(quint32 id, const QByteArray & payload);
+  bool readFrame(quint32 & id, QByteArray & payload);
+  bool readAnswer(quint32 id, QByteArray & answer);
+  QString _socketKey;
+  int _protocol;
+  QLocalSocket * _session;
+  quint32 _nextId;
+  QSet<quint32> _postedIds;
+  QVector<QSharedMemory *> _outputSegments;
+};
+
+#endif // _GMIC_QT_KRITACLIENT_H_
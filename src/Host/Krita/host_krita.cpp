@@ -28,16 +28,13 @@
 #include <QSharedMemory>
 #include <QFileInfo>
 #include <QDesktopWidget>
-#include <QLocalServer>
-#include <QLocalSocket>
-#include <QDataStream>
 #include <QBuffer>
-#include <QUuid>
 
 #include <ImageConverter.h>
 
 #include <algorithm>
 #include "Host/host.h"
+#include "Host/Krita/KritaClient.h"
 #include "gmic_qt.h"
 #include "gmic.h"
 
@@ -53,7 +50,9 @@
  *
  * key,imagename
  *
- * After a message has been received, "ack" is sent
+ * After a message has been received, "ack" is sent.
+ * Krita versions knowing protocol 2 keep a session open instead,
+ * see KritaClient.h.
  *
  */
 
@@ -63,75 +62,16 @@ const char *HostApplicationShortname = GMIC_QT_XSTRINGIFY(GMIC_HOST);
 }
 
 static QString socketKey = "gmic-krita";
-static const char ack[] = "ack";
-static QVector<QSharedMemory*> sharedMemorySegments;
 
-
-QByteArray sendMessageSynchronously(const QByteArray ba)
+static KritaClient &kritaClient()
 {
-    QByteArray answer;
-
-    // Send a message to Krita to ask for the images and image with the given crop and mode
-    QLocalSocket socket;
-    socket.connectToServer(socketKey);
-    bool connected = socket.waitForConnected(1000);
-    if (!connected) {
-        qWarning() << "Could not connect to the Krita instance.";
-        return answer;
-    }
-
-    // Send the message to Krita
-    QDataStream ds(&socket);
-    ds.writeBytes(ba.constData(), ba.length());
-    socket.waitForBytesWritten();
-
-    while (socket.bytesAvailable() < static_cast<int>(sizeof(quint32))) {
-        if (!socket.isValid()) {
-            qWarning() << "Stale request";
-            return answer;
-        }
-        socket.waitForReadyRead(1000);
-    }
-
-    // Get the answer
-    quint32 remaining;
-    ds >> remaining;
-    answer.resize(remaining);
-    int got = 0;
-    char *answerBuf = answer.data();
-    do {
-        got = ds.readRawData(answerBuf, remaining);
-        remaining -= got;
-        answerBuf += got;
-    } while (remaining && got >= 0 && socket.waitForReadyRead(2000));
-
-    if (got < 0) {
-        qWarning() << "Could not receive the answer." << socket.errorString();
-        return answer;
-    }
-
-    // Acknowledge receipt
-    socket.write(ack, qstrlen(ack));
-    socket.waitForBytesWritten(1000);
-    socket.disconnectFromServer();
-
-    return answer;
+    static KritaClient client(socketKey);
+    return client;
 }
 
 void gmic_qt_get_layers_extent(int *width, int *height, GmicQt::InputMode mode)
 {
-    *width = 0;
-    *height = 0;
-    QByteArray command = QString("command=gmic_qt_get_image_size\nmode=%1").arg((int)mode).toUtf8();
-
-    QString answer = QString::fromUtf8(sendMessageSynchronously(command));
-    if (answer.length() > 0) {
-        QList<QString> wh = answer.split(',', QString::SkipEmptyParts);
-        if (wh.length() == 2) {
-            *width = wh[0].toInt();
-            *height = wh[1].toInt();
-        }
-    }
+    kritaClient().getLayersExtent((int)mode, *width, *height);
 
     //qDebug() << "gmic-qt: layers extent:" << *width << *height;
 }
@@ -152,77 +92,7 @@ void gmic_qt_get_cropped_images(gmic_list<float> & images,
       height = 1.0;
     }
 
-    // Create a message for Krita
-    QString message = QString("command=gmic_qt_get_cropped_images\nmode=%5\ncroprect=%1,%2,%3,%4").arg(x).arg(y).arg(width).arg(height).arg(mode);
-    QByteArray command = message.toUtf8();
-    QString answer = QString::fromUtf8(sendMessageSynchronously(command));
-
-    if (answer.isEmpty()) {
-        qWarning() << "\tgmic-qt: empty answer!";
-        return;
-    }
-
-    //qDebug() << "\tgmic-qt: " << answer;
-
-    QStringList imagesList = answer.split("\n", QString::SkipEmptyParts);
-
-    images.assign(imagesList.size());
-    imageNames.assign(imagesList.size());
-
-    //qDebug() << "\tgmic-qt: imagelist size" << imagesList.size();
-
-    // Parse the answer -- there should be no new lines in layernames
-    QStringList memoryKeys;
-    QList<QSize> sizes;
-    // Get the keys for the shared memory areas and the imageNames as prepared by Krita in G'Mic format
-    for (int i = 0; i < imagesList.length(); ++i) {
-        const QString &layer = imagesList[i];
-        QStringList parts = layer.split(',', QString::SkipEmptyParts);
-        if (parts.size() != 4) {
-            qWarning() << "\tgmic-qt: Got the wrong answer!";
-        }
-        memoryKeys << parts[0];
-        QByteArray ba = parts[1].toLatin1();
-        ba = QByteArray::fromHex(ba);
-        gmic_image<char>::string(ba.constData()).move_to(imageNames[i]);
-        sizes << QSize(parts[2].toInt(), parts[3].toInt());
-    }
-
-    //qDebug() << "\tgmic-qt: keys" << memoryKeys;
-
-    // Fill images from the shared memory areas
-    for (int i = 0; i < memoryKeys.length(); ++i) {
-        const QString &key = memoryKeys[i];
-        QSharedMemory m(key);
-
-        if (!m.attach(QSharedMemory::ReadOnly)) {
-            qWarning() << "\tgmic-qt: Could not attach to shared memory area." << m.error() << m.errorString();
-        }
-        if (m.isAttached()) {
-            if (!m.lock()) {
-                qWarning() << "\tgmic-qt: Could not lock memeory segment"  << m.error() << m.errorString();
-            }
-            //qDebug() << "Memory segment" << key << m.size() << m.constData() << m.data();
-
-            // convert the data to the list of float
-            gmic_image<float> gimg;
-            gimg.assign(sizes[i].width(), sizes[i].height(), 1, 4);
-            memcpy(gimg._data, m.constData(), sizes[i].width() * sizes[i].height() * 4 * sizeof(float));
-            gimg.move_to(images[i]);
-
-            if (!m.unlock()) {
-                qWarning() << "\tgmic-qt: Could not unlock memeory segment"  << m.error() << m.errorString();
-            }
-            if (!m.detach()) {
-                qWarning() << "\tgmic-qt: Could not detach from memeory segment"  << m.error() << m.errorString();
-            }
-        }
-        else {
-            qWarning() << "gmic-qt: Could not attach to shared memory area." << m.error() << m.errorString();
-        }
-    }
-
-    sendMessageSynchronously("command=gmic_qt_detach");
+    kritaClient().getCroppedImages((int)mode, x, y, width, height, images, imageNames);
 
     //qDebug() << "\tgmic-qt:  Images size" << images.size() << ", names size" << imageNames.size();
 }
@@ -235,46 +105,71 @@ void gmic_qt_output_images( gmic_list<float> & images,
 
     //qDebug() << "qmic-qt-output-images";
 
-    Q_FOREACH(QSharedMemory *sharedMemory, sharedMemorySegments) {
-        if (sharedMemory->isAttached()) {
-            sharedMemory->detach();
-        }
-    }
-    qDeleteAll(sharedMemorySegments);
-    sharedMemorySegments.clear();
-
-    //qDebug() << "\tqmic-qt: shared memory" << sharedMemorySegments.count();
-
-    // Create qsharedmemory segments for each image
-    // Create a message for Krita based on mode, the keys of the qsharedmemory segments and the imageNames
-    QString message = QString("command=gmic_qt_output_images\nmode=%1\n").arg(mode);
-
-    for (uint i = 0; i < images.size(); ++i) {
-
-        //qDebug() << "\tgmic-qt: image number" << i;
+    kritaClient().outputImages(images, imageNames, (int)mode);
+}
 
-        gmic_image<float> gimg = images.at(i);
+static QSharedMemory *tiledOutputSegment = 0;
+static int tiledOutputWidth = 0;
+static int tiledOutputHeight = 0;
+static QByteArray tiledOutputMessage;
 
-        QSharedMemory *m = new QSharedMemory(QString("key_%1").arg(QUuid::createUuid().toString()));
-        sharedMemorySegments.append(m);
+bool gmic_qt_begin_tiled_output(int width, int height, int spectrum,
+                                const gmic_list<char> & imageNames,
+                                GmicQt::OutputMode mode,
+                                const char * /*verboseLayersLabel*/)
+{
+    // Tiles are written straight into the segment read by Krita, which is
+    // sent as a regular gmic_qt_output_images message once complete.
+    kritaClient().releaseOutputSegments();
+    if (!imageNames.size()) {
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(width) * height * spectrum * sizeof(float);
+    QSharedMemory *m = kritaClient().createOutputSegment(bytes);
+    if (!m) {
+        return false;
+    }
+    tiledOutputSegment = m;
+    tiledOutputWidth = width;
+    tiledOutputHeight = height;
+
+    const QByteArray layerName((const char *const)imageNames[0]);
+    tiledOutputMessage = QString("command=gmic_qt_output_images\nmode=%1\n").arg(mode).toUtf8();
+    tiledOutputMessage += KritaClient::outputLayerLine(*m, layerName, spectrum, width, height);
+    return true;
+}
 
-        if (!m->create(gimg._width * gimg._height * gimg._spectrum * sizeof(float))) {
-            qWarning() << "Could not create shared memory" << m->error() << m->errorString();
-            return;
+void gmic_qt_output_tile(gmic_image<float> & tile, int x, int y)
+{
+    if (!tiledOutputSegment) {
+        return;
+    }
+    // Same planar layout as a whole gmic_image<float>
+    tiledOutputSegment->lock();
+    float *data = static_cast<float*>(tiledOutputSegment->data());
+    const size_t plane = static_cast<size_t>(tiledOutputWidth) * tiledOutputHeight;
+    for (int c = 0; c < tile.spectrum(); ++c) {
+        for (int row = 0; row < tile.height(); ++row) {
+            memcpy(data + c * plane + static_cast<size_t>(y + row) * tiledOutputWidth + x,
+                   tile.data(0, row, 0, c),
+                   tile.width() * sizeof(float));
         }
+    }
+    tiledOutputSegment->unlock();
+}
 
-        m->lock();
-        memcpy(m->data(), gimg._data, gimg._width * gimg._height * gimg._spectrum * sizeof(float));
-        m->unlock();
-
-        QString layerName((const char *const)imageNames[i]);
-
-        message += "layer=" + m->key() + ","
-                + layerName.toUtf8().toHex() + ","
-                + QString("%1,%2,%3").arg(gimg._spectrum).arg(gimg._width).arg(gimg._height)
-                + + "\n";
+void gmic_qt_end_tiled_output(bool commit)
+{
+    if (!tiledOutputSegment) {
+        return;
     }
-    sendMessageSynchronously(message.toUtf8());
+    tiledOutputSegment = 0;
+    if (commit) {
+        kritaClient().request(tiledOutputMessage);
+    } else {
+        kritaClient().releaseOutputSegments();
+    }
+    tiledOutputMessage.clear();
 }
 
 void gmic_qt_show_message(const char * )
@@ -352,15 +247,8 @@ int main(int argc, char *argv[])
     else {
         r = launchPlugin();
     }
-
-    Q_FOREACH(QSharedMemory *sharedMemory, sharedMemorySegments) {
-        if (sharedMemory->isAttached()) {
-            sharedMemory->detach();
-        }
-    }
-
-    qDeleteAll(sharedMemorySegments);
-    sharedMemorySegments.clear();
+    kritaClient().close();
+    kritaClient().releaseOutputSegments();
 
     return r;
 }
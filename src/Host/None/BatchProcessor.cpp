@@ -0,0 +1,388 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BatchProcessor.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "Host/None/BatchProcessor.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QThread>
+#include <functional>
+#include <iostream>
+#include "Common.h"
+#include "FilterParameters/FilterParametersWidget.h"
+#include "FilterSelector/FavesModel.h"
+#include "FilterSelector/FavesModelReader.h"
+#include "FilterSelector/FiltersCatalogueCache.h"
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "FilterThread.h"
+#include "GmicStdlib.h"
+#include "ImageConverter.h"
+#include "PreviewMode.h"
+#include "Updater.h"
+#include "gmic.h"
+
+struct BatchProcessor::Item {
+  QString filename;
+  QString outputName;
+  qint64 pixels;
+  gmic_list<float> images;
+  gmic_list<char> imageNames;
+  int errors;
+};
+
+namespace
+{
+class StageThread : public QThread {
+public:
+  StageThread(QObject * parent, const std::function<void()> & stage) : QThread(parent), _stage(stage) {}
+
+protected:
+  void run() override
+  {
+    _stage();
+  }
+
+private:
+  std::function<void()> _stage;
+};
+}
+
+BatchProcessor::BatchProcessor(QObject * parent, const QString & filterName, const QString & command, const QString & arguments, const QStringList & files, const QString & outputDirectory,
+                               int jobs, int maxMegapixels)
+    : QObject(parent), _filterName(filterName), _command(command), _arguments(arguments), _files(files), _outputDirectory(outputDirectory), _jobs(std::max(1, jobs)),
+      _maxPixels(1000000 * (qint64)std::max(1, maxMegapixels)), _finishedFiles(0), _errorCount(0), _interpreterPool(std::max(1, jobs)), _pixelsInFlight(0), _stopping(false), _decodeTime(0),
+      _filterTime(0), _encodeTime(0)
+{
+  // Inputs with the same name in different folders (a/x.png, b/x.png) get
+  // numbered results (x.png, x-2.png) instead of overwriting each other
+  QSet<QString> outputNames;
+  for (const QString & file : _files) {
+    const QFileInfo info(file);
+    const QString path = info.canonicalFilePath();
+    if (!path.isEmpty()) {
+      _canonicalInputFiles.insert(path);
+    }
+    QString outputName = info.fileName();
+    for (int n = 2; outputNames.contains(outputName.toLower()); ++n) {
+      outputName = info.suffix().isEmpty() ? QString("%1-%2").arg(info.completeBaseName()).arg(n) : QString("%1-%2.%3").arg(info.completeBaseName()).arg(n).arg(info.suffix());
+    }
+    outputNames.insert(outputName.toLower());
+    _outputNames.push_back(outputName);
+  }
+  _decoder = new StageThread(this, [this]() { decodeImages(); });
+  _encoder = new StageThread(this, [this]() { encodeImages(); });
+  connect(this, SIGNAL(imageDecoded()), this, SLOT(onImageDecoded()), Qt::QueuedConnection);
+  connect(this, SIGNAL(imageEncoded()), this, SLOT(onImageEncoded()), Qt::QueuedConnection);
+}
+
+BatchProcessor::~BatchProcessor()
+{
+  {
+    QMutexLocker locker(&_mutex);
+    _stopping = true;
+    _decoderCondition.wakeAll();
+    _encoderCondition.wakeAll();
+  }
+  _decoder->wait();
+  _encoder->wait();
+  qDeleteAll(_decodedItems);
+  qDeleteAll(_filteredItems);
+  qDeleteAll(_encodedItems);
+  qDeleteAll(_runningItems);
+}
+
+int BatchProcessor::errorCount() const
+{
+  return _errorCount;
+}
+
+bool BatchProcessor::findFilter(const QString & filter, QString & name, QString & command, QString & arguments)
+{
+  // Same stdlib as the GUI (custom and downloaded sources included), which
+  // also lets both share the filters catalogue cache.
+  Updater::getInstance()->updateSources(false);
+  GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+  FiltersModel filtersModel;
+  if (!FiltersCatalogueCache::read(filtersModel, GmicStdLib::Array)) {
+    FiltersModelReader filterModelReader(filtersModel);
+    filterModelReader.parseFiltersDefinitions(GmicStdLib::Array);
+    FiltersCatalogueCache::write(filtersModel, GmicStdLib::Array);
+  }
+  // Arguments are built by the parameters of the filter, as in the GUI (defaults, quoting)
+  QString error;
+  if (filtersModel.contains(filter)) {
+    const FiltersModel::Filter & f = filtersModel.getFilterFromHash(filter);
+    name = f.plainText();
+    command = f.command();
+    if (!FilterParametersWidget::buildValueString(f.hash(), f.parameters(), QList<QString>(), arguments, error)) {
+      std::cerr << "[gmic_qt] " << name.toLocal8Bit().constData() << ": " << error.toLocal8Bit().constData() << "\n";
+      return false;
+    }
+    return true;
+  }
+  FavesModel favesModel;
+  FavesModelReader favesModelReader(favesModel);
+  favesModelReader.loadFaves();
+  for (FavesModel::const_iterator it = favesModel.cbegin(); it != favesModel.cend(); ++it) {
+    if ((it->hash() == filter) || (it->name() == filter) || (it->plainText() == filter)) {
+      name = it->plainText();
+      command = it->command();
+      if (!filtersModel.contains(it->originalHash())) {
+        std::cerr << "[gmic_qt] Filter of fave " << name.toLocal8Bit().constData() << " not found: " << it->originalName().toLocal8Bit().constData() << "\n";
+        return false;
+      }
+      const FiltersModel::Filter & f = filtersModel.getFilterFromHash(it->originalHash());
+      if (!FilterParametersWidget::buildValueString(f.hash(), f.parameters(), it->defaultValues(), arguments, error)) {
+        std::cerr << "[gmic_qt] " << name.toLocal8Bit().constData() << ": " << error.toLocal8Bit().constData() << "\n";
+        return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+QStringList BatchProcessor::expandFilenames(const QStringList & filenames)
+{
+  QStringList result;
+  const QRegExp wildcard("[*?\\[]");
+  for (const QString & filename : filenames) {
+    QFileInfo info(filename);
+    if (!info.fileName().contains(wildcard)) {
+      result.push_back(filename);
+      continue;
+    }
+    QDir dir = info.dir();
+    for (const QString & entry : dir.entryList(QStringList() << info.fileName(), QDir::Files | QDir::Readable, QDir::Name)) {
+      result.push_back(dir.filePath(entry));
+    }
+  }
+  return result;
+}
+
+void BatchProcessor::start()
+{
+  _time.start();
+  if (_files.isEmpty()) {
+    finish();
+    return;
+  }
+  _decoder->start();
+  _encoder->start();
+}
+
+void BatchProcessor::decodeImages()
+{
+  for (int index = 0; index < _files.size(); ++index) {
+    const QString & filename = _files[index];
+    QImageReader reader(filename);
+    const QSize size = reader.size();
+    const qint64 pixels = size.isValid() ? (qint64)size.width() * size.height() : 0;
+    {
+      // Backpressure: the filter stage has enough work, or too many pixels are in flight
+      QMutexLocker locker(&_mutex);
+      while (!_stopping && ((_decodedItems.size() >= _jobs) || (_pixelsInFlight && (_pixelsInFlight + pixels > _maxPixels)))) {
+        _decoderCondition.wait(&_mutex);
+      }
+      if (_stopping) {
+        return;
+      }
+      _pixelsInFlight += pixels;
+    }
+    QTime time;
+    time.start();
+    Item * item = new Item;
+    item->filename = filename;
+    item->outputName = _outputNames[index];
+    item->pixels = pixels;
+    item->errors = 0;
+    QImage image;
+    if (reader.read(&image)) {
+      item->images.assign(1);
+      item->imageNames.assign(1);
+      ImageConverter::convert(image.convertToFormat(QImage::Format_ARGB32), item->images[0]);
+      item->pixels = (qint64)image.width() * image.height(); // Header size may have been missing
+      QByteArray name = QString("pos(0,0),name(%1)").arg(QFileInfo(filename).fileName()).toUtf8();
+      gmic_image<char>::string(name.constData()).move_to(item->imageNames[0]);
+    } else {
+      std::cerr << "[gmic_qt] Could not open file " << filename.toLocal8Bit().constData() << "\n";
+      item->errors = 1;
+    }
+    QMutexLocker locker(&_mutex);
+    _pixelsInFlight += item->pixels - pixels;
+    _decodeTime += time.elapsed();
+    _decodedItems.enqueue(item);
+    emit imageDecoded();
+  }
+}
+
+void BatchProcessor::onImageDecoded()
+{
+  startFilterThreads();
+}
+
+void BatchProcessor::startFilterThreads()
+{
+  while (_runningItems.size() < _jobs) {
+    Item * item = nullptr;
+    {
+      QMutexLocker locker(&_mutex);
+      if (_decodedItems.isEmpty()) {
+        return;
+      }
+      item = _decodedItems.dequeue();
+      _decoderCondition.wakeAll();
+    }
+    if (item->errors) {
+      finishItem(item);
+      continue;
+    }
+    FilterThread * thread = new FilterThread(this, _filterName, _command, _arguments, environment(), GmicQt::Quiet);
+    thread->setInterpreterPool(&_interpreterPool);
+    thread->swapImages(item->images);
+    thread->setImageNames(item->imageNames);
+    connect(thread, SIGNAL(finished()), this, SLOT(onFilterThreadFinished()));
+    _runningItems[thread] = item;
+    thread->start();
+  }
+}
+
+void BatchProcessor::onFilterThreadFinished()
+{
+  FilterThread * thread = dynamic_cast<FilterThread *>(sender());
+  Q_ASSERT_X(thread && _runningItems.contains(thread), __PRETTY_FUNCTION__, "Unknown thread");
+  Item * item = _runningItems.take(thread);
+  _filterTime += thread->duration();
+  if (thread->failed()) {
+    std::cerr << "[gmic_qt] " << item->filename.toLocal8Bit().constData() << ": " << thread->errorMessage().toLocal8Bit().constData() << "\n";
+    item->errors = 1;
+    finishItem(item);
+  } else {
+    thread->swapImages(item->images);
+    QMutexLocker locker(&_mutex);
+    _filteredItems.enqueue(item);
+    _encoderCondition.wakeAll();
+  }
+  thread->deleteLater();
+  startFilterThreads();
+}
+
+void BatchProcessor::encodeImages()
+{
+  for (;;) {
+    Item * item = nullptr;
+    {
+      QMutexLocker locker(&_mutex);
+      while (!_stopping && _filteredItems.isEmpty()) {
+        _encoderCondition.wait(&_mutex);
+      }
+      if (_stopping) {
+        return;
+      }
+      item = _filteredItems.dequeue();
+    }
+    QTime time;
+    time.start();
+    const QFileInfo info(item->outputName);
+    for (unsigned int i = 0; i < item->images.size(); ++i) {
+      QString outputName;
+      if (item->images.size() == 1) {
+        outputName = info.fileName();
+      } else {
+        outputName = QString("%1_%2.%3").arg(info.completeBaseName()).arg(i).arg(info.suffix());
+      }
+      QString outputFilename = QDir(_outputDirectory).filePath(outputName);
+      if (_canonicalInputFiles.contains(QFileInfo(outputFilename).canonicalFilePath())) {
+        // Results are written next to the inputs: do not overwrite them
+        outputFilename = QDir(_outputDirectory).filePath(QString("%1_gmic.%2").arg(QFileInfo(outputName).completeBaseName()).arg(info.suffix()));
+      }
+      QImage image;
+      ImageConverter::convert(item->images[i], image);
+      item->images[i].assign();
+      if (!image.save(outputFilename)) {
+        std::cerr << "[gmic_qt] Could not write file " << outputFilename.toLocal8Bit().constData() << "\n";
+        ++item->errors;
+      }
+    }
+    QMutexLocker locker(&_mutex);
+    _encodeTime += time.elapsed();
+    _encodedItems.enqueue(item);
+    emit imageEncoded();
+  }
+}
+
+void BatchProcessor::onImageEncoded()
+{
+  QQueue<Item *> items;
+  {
+    QMutexLocker locker(&_mutex);
+    items.swap(_encodedItems);
+  }
+  for (Item * item : items) {
+    finishItem(item);
+  }
+}
+
+void BatchProcessor::finishItem(Item * item)
+{
+  {
+    QMutexLocker locker(&_mutex);
+    _pixelsInFlight -= item->pixels;
+    _decoderCondition.wakeAll();
+  }
+  _errorCount += item->errors;
+  delete item;
+  if (++_finishedFiles == _files.size()) {
+    finish();
+  }
+}
+
+void BatchProcessor::finish()
+{
+  {
+    QMutexLocker locker(&_mutex);
+    _stopping = true;
+    _decoderCondition.wakeAll();
+    _encoderCondition.wakeAll();
+  }
+  _decoder->wait();
+  _encoder->wait();
+  const qint64 elapsed = std::max(1, _time.elapsed());
+  std::cout << "[gmic_qt] " << _files.size() << " file(s) processed in " << elapsed << " ms, " << _errorCount << " error(s)\n";
+  std::cout << "[gmic_qt] Stage utilisation: decode " << (100 * _decodeTime) / elapsed << "%, filter " << (100 * _filterTime) / (elapsed * _jobs) << "% (" << _jobs << " jobs), encode "
+            << (100 * _encodeTime) / elapsed << "%\n";
+  emit done(_errorCount);
+  qApp->exit(_errorCount ? 1 : 0);
+}
+
+QString BatchProcessor::environment()
+{
+  return QString("_input_layers=%1 _output_mode=%2 _output_messages=%3 _preview_mode=%4").arg(GmicQt::Active).arg(GmicQt::InPlace).arg(GmicQt::Quiet).arg(GmicQt::FirstOutput);
+}
@@ -0,0 +1,136 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BatchProcessor.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_BATCHPROCESSOR_H_
+#define _GMIC_QT_BATCHPROCESSOR_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+#include <QWaitCondition>
+#include "GmicInterpreterPool.h"
+
+class FilterThread;
+class QThread;
+
+/**
+ * @brief Runs one filter over a list of image files, without any GUI
+ *        (standalone host, --batch mode).
+ *
+ *        Files go through a three-stage pipeline: a decoder thread loads and
+ *        converts images, up to jobs filter threads run the command, and an
+ *        encoder thread converts and saves the results. Stages are linked by
+ *        bounded queues; the decoder waits whenever the images in flight
+ *        (decoded, filtered or waiting to be saved) exceed a megapixel budget.
+ *
+ *        Interpreters are shared by all filter threads through a
+ *        GmicInterpreterPool, so that the stdlib is parsed at most once per job.
+ */
+class BatchProcessor : public QObject {
+  Q_OBJECT
+
+public:
+  BatchProcessor(QObject * parent, const QString & filterName, const QString & command, const QString & arguments, const QStringList & files, const QString & outputDirectory, int jobs,
+                 int maxMegapixels);
+  ~BatchProcessor();
+  int errorCount() const;
+
+  /**
+   * @brief Find a filter from its hash, or a fave from its name
+   *
+   * @param filter Filter hash or fave name
+   * @param[out] name Name of the filter
+   * @param[out] command G'MIC command of the filter
+   * @param[out] arguments Values of the fave, or defaults of the filter, quoted as in the GUI
+   * @return true if a filter or a fave was found
+   */
+  static bool findFilter(const QString & filter, QString & name, QString & command, QString & arguments);
+
+  /**
+   * @brief Expand wildcards ('*', '?' or '[') in the file part of filenames
+   */
+  static QStringList expandFilenames(const QStringList & filenames);
+
+  static const int DefaultMaxMegapixels = 128;
+
+public slots:
+  void start();
+
+signals:
+  void done(int errorCount);
+  void imageDecoded();
+  void imageEncoded();
+
+private slots:
+  void onImageDecoded();
+  void onFilterThreadFinished();
+  void onImageEncoded();
+
+private:
+  struct Item;
+  void decodeImages(); // Decoder thread
+  void encodeImages(); // Encoder thread
+  void startFilterThreads();
+  void finishItem(Item * item);
+  void finish();
+  static QString environment();
+  QString _filterName;
+  QString _command;
+  QString _arguments;
+  QStringList _files;
+  QStringList _outputNames;           // Unique file name of the result of each input file
+  QSet<QString> _canonicalInputFiles; // Never overwritten by a result
+  QString _outputDirectory;
+  int _jobs;
+  qint64 _maxPixels;
+  int _finishedFiles;
+  int _errorCount;
+  QHash<FilterThread *, Item *> _runningItems;
+  GmicInterpreterPool _interpreterPool;
+  QThread * _decoder;
+  QThread * _encoder;
+
+  // Shared with the decoder and encoder threads
+  QMutex _mutex;
+  QWaitCondition _decoderCondition;
+  QWaitCondition _encoderCondition;
+  QQueue<Item *> _decodedItems;
+  QQueue<Item *> _filteredItems;
+  QQueue<Item *> _encodedItems;
+  qint64 _pixelsInFlight;
+  bool _stopping;
+
+  // Utilisation
+  QTime _time;
+  qint64 _decodeTime;
+  qint64 _filterTime;
+  qint64 _encodeTime;
+};
+
+#endif // _GMIC_QT_BATCHPROCESSOR_H_
@@ -23,15 +23,22 @@
  *
  */
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDebug>
 #include <QDesktopWidget>
+#include <QDir>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QProcess>
 #include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "Common.h"
+#include "Globals.h"
+#include "Host/None/BatchProcessor.h"
 #include "Host/None/ImageDialog.h"
 #include "Host/host.h"
 #include "ImageConverter.h"
@@ -139,14 +146,83 @@ void gmic_qt_output_images(gmic_list<float> & images, const gmic_list<char> & im
   unused(verboseLayersLabel);
 }
 
+bool gmic_qt_begin_tiled_output(int, int, int, const gmic_list<char> &, GmicQt::OutputMode, const char *)
+{
+  return false; // Results are shown in a dialog, as whole images
+}
+
+void gmic_qt_output_tile(gmic_image<float> &, int, int) {}
+
+void gmic_qt_end_tiled_output(bool) {}
+
 void gmic_qt_show_message(const char * message)
 {
   std::cout << message << std::endl;
 }
 
+int launchBatch(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setOrganizationName(GMIC_QT_ORGANISATION_NAME);
+  QCoreApplication::setOrganizationDomain(GMIC_QT_ORGANISATION_DOMAIN);
+  QCoreApplication::setApplicationName(GMIC_QT_APPLICATION_NAME);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("G'MIC-Qt batch mode: apply a filter to image files");
+  parser.addHelpOption();
+  QCommandLineOption batchOption("batch", "Process files without GUI.");
+  QCommandLineOption filterOption(QStringList() << "f" << "filter", "Hash of the filter, or name of the fave, to apply.", "filter");
+  QCommandLineOption argumentsOption(QStringList() << "a" << "arguments", "Comma-separated filter arguments (default: fave values or command defaults).", "arguments");
+  QCommandLineOption outputOption(QStringList() << "o" << "output-dir", "Directory where results are written (default: current directory). Input files are never overwritten.", "directory", ".");
+  QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Number of files processed at the same time.", "count", QString::number(QThread::idealThreadCount()));
+  QCommandLineOption memoryOption(QStringList() << "m" << "max-megapixels", "Maximum size of the images in flight, in megapixels.", "megapixels",
+                                  QString::number(BatchProcessor::DefaultMaxMegapixels));
+  parser.addOption(batchOption);
+  parser.addOption(filterOption);
+  parser.addOption(argumentsOption);
+  parser.addOption(outputOption);
+  parser.addOption(jobsOption);
+  parser.addOption(memoryOption);
+  parser.addPositionalArgument("files", "Input files (wildcards are expanded).", "files...");
+  parser.process(app);
+
+  QString filterName;
+  QString command;
+  QString arguments;
+  if (!parser.isSet(filterOption) || !BatchProcessor::findFilter(parser.value(filterOption), filterName, command, arguments)) {
+    std::cerr << "Filter not found: " << parser.value(filterOption).toLocal8Bit().constData() << "\n";
+    return 1;
+  }
+  if (parser.isSet(argumentsOption)) {
+    arguments = parser.value(argumentsOption);
+  }
+  const QStringList files = BatchProcessor::expandFilenames(parser.positionalArguments());
+  if (files.isEmpty()) {
+    std::cerr << "No input file\n";
+    return 1;
+  }
+  if (!QDir().mkpath(parser.value(outputOption))) {
+    std::cerr << "Could not create directory " << parser.value(outputOption).toLocal8Bit().constData() << "\n";
+    return 1;
+  }
+  BatchProcessor processor(&app, filterName, command, arguments, files, parser.value(outputOption), parser.value(jobsOption).toInt(),
+                           parser.value(memoryOption).toInt());
+  QTimer idle;
+  idle.setInterval(0);
+  idle.setSingleShot(true);
+  QObject::connect(&idle, SIGNAL(timeout()), &processor, SLOT(start()));
+  idle.start();
+  return app.exec();
+}
+
 int main(int argc, char * argv[])
 {
   TIMING;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--batch")) {
+      return launchBatch(argc, argv);
+    }
+  }
   QString filename;
   if (argc == 2) {
     filename = argv[1];
@@ -88,6 +88,38 @@ void gmic_qt_get_cropped_images(cimg_library::CImgList<gmic_pixel_type> & images
  */
 void gmic_qt_output_images(cimg_library::CImgList<gmic_pixel_type> & images, const cimg_library::CImgList<char> & imageNames, GmicQt::OutputMode mode, const char * verboseLayersLabel = nullptr);
 
+/**
+ * @brief Start sending a single image to the host application tile by tile,
+ *        so that the whole image never needs to be held by the plugin.
+ *        This is used when a filter is applied by tiles.
+ *
+ * @param width Width of the whole image
+ * @param height Height of the whole image
+ * @param spectrum Number of channels of the tiles
+ * @param imageNames Layer label (a single one)
+ * @param mode Output mode (\see gmic_qt.cpp)
+ * @param verboseLayersLabel Name used for the layer in VerboseLayerName mode, otherwise null.
+ * @return false if the host cannot receive this image by tiles. The whole image
+ *         is then sent using gmic_qt_output_images().
+ */
+bool gmic_qt_begin_tiled_output(int width, int height, int spectrum, const cimg_library::CImgList<char> & imageNames, GmicQt::OutputMode mode, const char * verboseLayersLabel = nullptr);
+
+/**
+ * @brief Send a tile of the image announced by gmic_qt_begin_tiled_output()
+ *
+ * @param tile Tile pixels. May be modified.
+ * @param x Left coordinate of the tile in the image
+ * @param y Top coordinate of the tile in the image
+ */
+void gmic_qt_output_tile(cimg_library::CImg<gmic_pixel_type> & tile, int x, int y);
+
+/**
+ * @brief Finish the output started by gmic_qt_begin_tiled_output()
+ *
+ * @param commit If false (processing was aborted), the tiles already sent are discarded.
+ */
+void gmic_qt_end_tiled_output(bool commit);
+
 /**
  * @brief Apply a color profile to a given image
  *
@@ -24,8 +24,10 @@
  */
 
 #include "HtmlTranslator.h"
+#include <QCoreApplication>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QThread>
 #include "CImg.h"
 #include "Common.h"
 
@@ -34,6 +36,13 @@ QTextDocument HtmlTranslator::_document;
 QString HtmlTranslator::html2txt(const QString & str, bool force)
 {
   if (force || hasHtmlEntities(str)) {
+    // QTextDocument is only reentrant: the shared document belongs to the GUI
+    // thread, others (e.g. FiltersCatalogueThread) use their own.
+    if (QCoreApplication::instance() && (QThread::currentThread() != QCoreApplication::instance()->thread())) {
+      QTextDocument document;
+      document.setHtml(str);
+      return fromUtf8Escapes(document.toPlainText());
+    }
     _document.setHtml(str);
     return fromUtf8Escapes(_document.toPlainText());
   } else {
@@ -25,9 +25,28 @@
 #include "ImageConverter.h"
 #include <QDebug>
 #include <QImage>
+#include <QSize>
+#include <cstring>
+#include <vector>
 #include "Common.h"
+#include "Globals.h"
 #include "gmic.h"
 
+// SSE2 is part of the x86-64 baseline, so no runtime dispatch is needed:
+// other architectures (or 32 bits builds without -msse2) use the scalar loops.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define _GMIC_QT_SSE2_
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are built with a function target attribute (no -mavx2 needed)
+// and only used if the CPU running the plugin supports AVX2.
+#if defined(_GMIC_QT_SSE2_) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _GMIC_QT_AVX2_
+#include <immintrin.h>
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
 namespace
 {
 inline bool archIsLittleEndian()
@@ -35,195 +54,451 @@ inline bool archIsLittleEndian()
   const int x = 1;
   return (*reinterpret_cast<const unsigned char *>(&x));
 }
+
+// Values are saturated, then rounded to the nearest integer. The SIMD kernels
+// add 0.5 and truncate as well, so that all paths give the very same bytes.
+inline unsigned char float2uchar(float value)
+{
+  return static_cast<unsigned char>(((value <= 0.0f) ? 0.0f : ((value >= 255.0f) ? 255.0f : value)) + 0.5f);
 }
 
-void ImageConverter::convert(const cimg_library::CImg<float> & in, QImage & out)
+#ifdef _GMIC_QT_SSE2_
+inline __m128i sse2Float2Int(const float * src)
 {
-  Q_ASSERT_X(in.spectrum() <= 4, "ImageConverter::convert()", QString("bad input spectrum (%1)").arg(in.spectrum()).toLatin1());
-  ;
+  const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  return _mm_cvttps_epi32(_mm_add_ps(value, _mm_set1_ps(0.5f)));
+}
 
-  out = QImage(in.width(), in.height(), QImage::Format_RGB888);
+// Four pixels c0 | c1 << 8 | c2 << 16 | c3 << 24, i.e. bytes c0,c1,c2,c3 in memory (x86 is little endian)
+inline __m128i sse2Pack4(const float * c0, const float * c1, const float * c2, const float * c3)
+{
+  __m128i result = sse2Float2Int(c0);
+  result = _mm_or_si128(result, _mm_slli_epi32(sse2Float2Int(c1), 8));
+  result = _mm_or_si128(result, _mm_slli_epi32(sse2Float2Int(c2), 16));
+  if (c3) {
+    result = _mm_or_si128(result, _mm_slli_epi32(sse2Float2Int(c3), 24));
+  }
+  return result;
+}
 
-  if (in.spectrum() == 4 && out.format() != QImage::Format_ARGB32) {
-    out = out.convertToFormat(QImage::Format_ARGB32);
+inline void sse2Unpack4(__m128i pixels, float * c0, float * c1, float * c2, float * c3)
+{
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  _mm_storeu_ps(c0, _mm_cvtepi32_ps(_mm_and_si128(pixels, mask)));
+  _mm_storeu_ps(c1, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), mask)));
+  _mm_storeu_ps(c2, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), mask)));
+  if (c3) {
+    _mm_storeu_ps(c3, _mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24)));
   }
+}
 
-  if (in.spectrum() == 3 && out.format() != QImage::Format_RGB888) {
-    out = out.convertToFormat(QImage::Format_RGB888);
+inline int load3Bytes(const unsigned char * src)
+{
+  int value; // Reads one extra byte, callers make sure it is still within the scanline
+  std::memcpy(&value, src, sizeof(int));
+  return value;
+}
+#endif
+
+#ifdef _GMIC_QT_AVX2_
+bool cpuSupportsAvx2()
+{
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+AVX2_FUNCTION inline __m256i avx2Float2Int(const float * src)
+{
+  const __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src), _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+  return _mm256_cvttps_epi32(_mm256_add_ps(value, _mm256_set1_ps(0.5f)));
+}
+
+AVX2_FUNCTION inline __m256i avx2Pack8(const float * c0, const float * c1, const float * c2, const float * c3)
+{
+  __m256i result = avx2Float2Int(c0);
+  result = _mm256_or_si256(result, _mm256_slli_epi32(avx2Float2Int(c1), 8));
+  result = _mm256_or_si256(result, _mm256_slli_epi32(avx2Float2Int(c2), 16));
+  if (c3) {
+    result = _mm256_or_si256(result, _mm256_slli_epi32(avx2Float2Int(c3), 24));
   }
+  return result;
+}
 
-  if (in.spectrum() == 2 && out.format() != QImage::Format_ARGB32) {
-    out = out.convertToFormat(QImage::Format_ARGB32);
+AVX2_FUNCTION inline void avx2Unpack8(__m256i pixels, float * c0, float * c1, float * c2, float * c3)
+{
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  _mm256_storeu_ps(c0, _mm256_cvtepi32_ps(_mm256_and_si256(pixels, mask)));
+  _mm256_storeu_ps(c1, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask)));
+  _mm256_storeu_ps(c2, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask)));
+  if (c3) {
+    _mm256_storeu_ps(c3, _mm256_cvtepi32_ps(_mm256_srli_epi32(pixels, 24)));
   }
+}
 
-// Format_Grayscale8 was added in Qt 5.5.
-#if ((QT_VERSION_MAJOR == 5) && (QT_VERSION_MINOR > 4)) || (QT_VERSION_MAJOR >= 6)
-  if (in.spectrum() == 1 && out.format() != QImage::Format_Grayscale8) {
-    out = out.convertToFormat(QImage::Format_Grayscale8);
+// The AVX2 kernels return the number of pixels they converted, the rest of the row being left to the caller
+
+AVX2_FUNCTION int avx2PlanarToInterleaved4(const float * c0, const float * c1, const float * c2, const float * c3, unsigned char * dst, int n)
+{
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 4 * i), avx2Pack8(c0 + i, c1 + i, c2 + i, c3 + i));
   }
-#else
-  if (in.spectrum() == 1) {
-    out = out.convertToFormat(QImage::Format_RGB888);
+  return i;
+}
+
+AVX2_FUNCTION int avx2PlanarToInterleaved3(const float * c0, const float * c1, const float * c2, unsigned char * dst, int n)
+{
+  // Drop the 4th byte of each pixel, leaving 12 bytes at the start of each 128 bits lane
+  const __m256i compact = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned char bytes[32];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(bytes), _mm256_shuffle_epi8(avx2Pack8(c0 + i, c1 + i, c2 + i, nullptr), compact));
+    std::memcpy(dst + 3 * i, bytes, 12);
+    std::memcpy(dst + 3 * i + 12, bytes + 16, 12);
+  }
+  return i;
+}
+
+AVX2_FUNCTION int avx2PlanarToGray(const float * src, unsigned char * dst, int n)
+{
+  // Packing works within 128 bits lanes: put the groups of 4 pixels back in order
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i ab = _mm256_packs_epi32(avx2Float2Int(src + i), avx2Float2Int(src + i + 8));
+    const __m256i cd = _mm256_packs_epi32(avx2Float2Int(src + i + 16), avx2Float2Int(src + i + 24));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order));
+  }
+  return i;
+}
+
+AVX2_FUNCTION int avx2InterleavedToPlanar4(const unsigned char * src, float * c0, float * c1, float * c2, float * c3, int n)
+{
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    avx2Unpack8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 4 * i)), c0 + i, c1 + i, c2 + i, c3 + i);
   }
+  return i;
+}
+
+AVX2_FUNCTION int avx2InterleavedToPlanar3(const unsigned char * src, float * c0, float * c1, float * c2, int n)
+{
+  // 4 pixels (12 bytes) per 128 bits lane, each one spread over 32 bits
+  const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  int i = 0;
+  // Each lane is loaded with 16 bytes: keep at least two pixels for the caller
+  for (; i + 10 <= n; i += 8) {
+    const unsigned char * pixel = src + 3 * i;
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixel));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixel + 12));
+    avx2Unpack8(_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1), spread), c0 + i, c1 + i, c2 + i, nullptr);
+  }
+  return i;
+}
 #endif
 
-  if (in.spectrum() == 3) {
-    const float * srcR = in.data(0, 0, 0, 0);
-    const float * srcG = in.data(0, 0, 0, 1);
-    const float * srcB = in.data(0, 0, 0, 2);
-    int height = out.height();
-    for (int y = 0; y < height; ++y) {
-      int n = in.width();
-      unsigned char * dst = out.scanLine(y);
-      while (n--) {
-        dst[0] = static_cast<unsigned char>(*srcR++);
-        dst[1] = static_cast<unsigned char>(*srcG++);
-        dst[2] = static_cast<unsigned char>(*srcB++);
-        dst += 3;
-      }
+// Planar to interleaved, one row of n pixels. Channels are given in memory (byte) order.
+void planarToInterleaved4(const float * c0, const float * c1, const float * c2, const float * c3, unsigned char * dst, int n)
+{
+  int i = 0;
+#ifdef _GMIC_QT_AVX2_
+  if (cpuSupportsAvx2()) {
+    i = avx2PlanarToInterleaved4(c0, c1, c2, c3, dst, n);
+  }
+#endif
+#ifdef _GMIC_QT_SSE2_
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * i), sse2Pack4(c0 + i, c1 + i, c2 + i, c3 + i));
+  }
+#endif
+  for (; i < n; ++i) {
+    unsigned char * pixel = dst + 4 * i;
+    pixel[0] = float2uchar(c0[i]);
+    pixel[1] = float2uchar(c1[i]);
+    pixel[2] = float2uchar(c2[i]);
+    pixel[3] = float2uchar(c3[i]);
+  }
+}
+
+void planarToInterleaved3(const float * c0, const float * c1, const float * c2, unsigned char * dst, int n)
+{
+  int i = 0;
+#ifdef _GMIC_QT_AVX2_
+  if (cpuSupportsAvx2()) {
+    i = avx2PlanarToInterleaved3(c0, c1, c2, dst, n);
+  }
+#endif
+#ifdef _GMIC_QT_SSE2_
+  // Each pixel is written as 4 bytes, the 4th one being overwritten by the next pixel:
+  // keep at least one pixel for the scalar loop.
+  for (; i + 4 < n; i += 4) {
+    int pixels[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels), sse2Pack4(c0 + i, c1 + i, c2 + i, nullptr));
+    for (int k = 0; k < 4; ++k) {
+      std::memcpy(dst + 3 * (i + k), pixels + k, sizeof(int));
     }
+  }
+#endif
+  for (; i < n; ++i) {
+    unsigned char * pixel = dst + 3 * i;
+    pixel[0] = float2uchar(c0[i]);
+    pixel[1] = float2uchar(c1[i]);
+    pixel[2] = float2uchar(c2[i]);
+  }
+}
+
+void planarToGray(const float * src, unsigned char * dst, int n)
+{
+  int i = 0;
+#ifdef _GMIC_QT_AVX2_
+  if (cpuSupportsAvx2()) {
+    i = avx2PlanarToGray(src, dst, n);
+  }
+#endif
+#ifdef _GMIC_QT_SSE2_
+  for (; i + 16 <= n; i += 16) {
+    const __m128i low = _mm_packs_epi32(sse2Float2Int(src + i), sse2Float2Int(src + i + 4));
+    const __m128i high = _mm_packs_epi32(sse2Float2Int(src + i + 8), sse2Float2Int(src + i + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(low, high));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = float2uchar(src[i]);
+  }
+}
+
+// Interleaved to planar, one row of n pixels. Channels are given in memory (byte) order.
+void interleavedToPlanar4(const unsigned char * src, float * c0, float * c1, float * c2, float * c3, int n)
+{
+  int i = 0;
+#ifdef _GMIC_QT_AVX2_
+  if (cpuSupportsAvx2()) {
+    i = avx2InterleavedToPlanar4(src, c0, c1, c2, c3, n);
+  }
+#endif
+#ifdef _GMIC_QT_SSE2_
+  for (; i + 4 <= n; i += 4) {
+    sse2Unpack4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * i)), c0 + i, c1 + i, c2 + i, c3 + i);
+  }
+#endif
+  for (; i < n; ++i) {
+    const unsigned char * pixel = src + 4 * i;
+    c0[i] = static_cast<float>(pixel[0]);
+    c1[i] = static_cast<float>(pixel[1]);
+    c2[i] = static_cast<float>(pixel[2]);
+    c3[i] = static_cast<float>(pixel[3]);
+  }
+}
+
+void interleavedToPlanar3(const unsigned char * src, float * c0, float * c1, float * c2, int n)
+{
+  int i = 0;
+#ifdef _GMIC_QT_AVX2_
+  if (cpuSupportsAvx2()) {
+    i = avx2InterleavedToPlanar3(src, c0, c1, c2, n);
+  }
+#endif
+#ifdef _GMIC_QT_SSE2_
+  for (; i + 4 < n; i += 4) {
+    const unsigned char * pixel = src + 3 * i;
+    const __m128i pixels = _mm_and_si128(_mm_set_epi32(load3Bytes(pixel + 9), load3Bytes(pixel + 6), load3Bytes(pixel + 3), load3Bytes(pixel)), _mm_set1_epi32(0xFFFFFF));
+    sse2Unpack4(pixels, c0 + i, c1 + i, c2 + i, nullptr);
+  }
+#endif
+  for (; i < n; ++i) {
+    const unsigned char * pixel = src + 3 * i;
+    c0[i] = static_cast<float>(pixel[0]);
+    c1[i] = static_cast<float>(pixel[1]);
+    c2[i] = static_cast<float>(pixel[2]);
+  }
+}
+
+// One scanline of a planar float image to an 8 bits QImage format (see ImageConverter::convert())
+void convertRow(const cimg_library::CImg<float> & in, int y, unsigned char * dst, bool littleEndian)
+{
+  const int width = in.width();
+  if (in.spectrum() == 3) {
+    planarToInterleaved3(in.data(0, y, 0, 0), in.data(0, y, 0, 1), in.data(0, y, 0, 2), dst, width);
   } else if (in.spectrum() == 4) {
-    const float * srcR = in.data(0, 0, 0, 0);
-    const float * srcG = in.data(0, 0, 0, 1);
-    const float * srcB = in.data(0, 0, 0, 2);
-    const float * srcA = in.data(0, 0, 0, 3);
-    int height = out.height();
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[0] = static_cast<unsigned char>(*srcB++);
-          dst[1] = static_cast<unsigned char>(*srcG++);
-          dst[2] = static_cast<unsigned char>(*srcR++);
-          dst[3] = static_cast<unsigned char>(*srcA++);
-          dst += 4;
-        }
-      }
+    const float * srcR = in.data(0, y, 0, 0);
+    const float * srcG = in.data(0, y, 0, 1);
+    const float * srcB = in.data(0, y, 0, 2);
+    const float * srcA = in.data(0, y, 0, 3);
+    if (littleEndian) {
+      planarToInterleaved4(srcB, srcG, srcR, srcA, dst, width);
     } else {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[0] = static_cast<unsigned char>(*srcA++);
-          dst[1] = static_cast<unsigned char>(*srcR++);
-          dst[2] = static_cast<unsigned char>(*srcG++);
-          dst[3] = static_cast<unsigned char>(*srcB++);
-          dst += 4;
-        }
-      }
+      planarToInterleaved4(srcA, srcR, srcG, srcB, dst, width);
     }
   } else if (in.spectrum() == 2) {
     //
     // Gray + Alpha
     //
-    const float * src = in.data(0, 0, 0, 0);
-    const float * srcA = in.data(0, 0, 0, 1);
-    int height = out.height();
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[2] = dst[1] = dst[0] = static_cast<unsigned char>(*src++);
-          dst[3] = static_cast<unsigned char>(*srcA++);
-          dst += 4;
-        }
-      }
+    const float * src = in.data(0, y, 0, 0);
+    const float * srcA = in.data(0, y, 0, 1);
+    if (littleEndian) {
+      planarToInterleaved4(src, src, src, srcA, dst, width);
     } else {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[1] = dst[2] = dst[3] = static_cast<unsigned char>(*src++);
-          dst[0] = static_cast<unsigned char>(*srcA++);
-          dst += 4;
-        }
-      }
+      planarToInterleaved4(srcA, src, src, src, dst, width);
     }
   } else {
     //
     // 8-bits Gray levels
     //
-    const float * src = in.data(0, 0, 0, 0);
-    int height = out.height();
-    for (int y = 0; y < height; ++y) {
-      int n = in.width();
-      unsigned char * dst = out.scanLine(y);
+    const float * src = in.data(0, y, 0, 0);
 #if ((QT_VERSION_MAJOR == 5) && (QT_VERSION_MINOR > 4)) || (QT_VERSION_MAJOR >= 6)
-      while (n--) {
-        *dst++ = static_cast<unsigned char>(*src++);
-      }
+    planarToGray(src, dst, width);
 #else
-      while (n--) {
-        dst[0] = static_cast<unsigned char>(*src);
-        dst[1] = static_cast<unsigned char>(*src);
-        dst[2] = static_cast<unsigned char>(*src);
-        ++src;
-        dst += 3;
-      }
+    planarToInterleaved3(src, src, src, dst, width);
 #endif
-    }
   }
 }
 
-void ImageConverter::convert(const QImage & in, cimg_library::CImg<float> & out)
+// One scanline of an ARGB32 or RGB888 QImage to a planar float image
+void convertRow(const unsigned char * src, cimg_library::CImg<float> & out, int y, bool littleEndian)
 {
-  Q_ASSERT_X(in.format() == QImage::Format_ARGB32 || in.format() == QImage::Format_RGB888, "convert", "bad input format");
+  const int width = out.width();
+  if (out.spectrum() == 4) {
+    float * dstR = out.data(0, y, 0, 0);
+    float * dstG = out.data(0, y, 0, 1);
+    float * dstB = out.data(0, y, 0, 2);
+    float * dstA = out.data(0, y, 0, 3);
+    if (littleEndian) {
+      interleavedToPlanar4(src, dstB, dstG, dstR, dstA, width);
+    } else {
+      interleavedToPlanar4(src, dstA, dstR, dstG, dstB, width);
+    }
+  } else {
+    interleavedToPlanar3(src, out.data(0, y, 0, 0), out.data(0, y, 0, 1), out.data(0, y, 0, 2), width);
+  }
+}
 
-  if (in.format() == QImage::Format_ARGB32) {
-    const int w = in.width();
-    const int h = in.height();
-    out.assign(w, h, 1, 4);
-    float * dstR = out.data(0, 0, 0, 0);
-    float * dstG = out.data(0, 0, 0, 1);
-    float * dstB = out.data(0, 0, 0, 2);
-    float * dstA = out.data(0, 0, 0, 3);
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < h; ++y) {
-        const unsigned char * src = in.scanLine(y);
-        int n = in.width();
-        while (n--) {
-          *dstB++ = static_cast<float>(src[0]);
-          *dstG++ = static_cast<float>(src[1]);
-          *dstR++ = static_cast<float>(src[2]);
-          *dstA++ = static_cast<float>(src[3]);
-          src += 4;
-        }
+// One scanline of the display image, nearest source pixels being given by xOffsets
+void convertDisplayRow(const cimg_library::CImg<float> & in, int sourceY, const std::vector<int> & xOffsets, QRgb * dst)
+{
+  const int width = static_cast<int>(xOffsets.size());
+  const int * offset = xOffsets.data();
+  if (in.spectrum() >= 3) {
+    const float * srcR = in.data(0, sourceY, 0, 0);
+    const float * srcG = in.data(0, sourceY, 0, 1);
+    const float * srcB = in.data(0, sourceY, 0, 2);
+    if (in.spectrum() == 4) {
+      const float * srcA = in.data(0, sourceY, 0, 3);
+      for (int x = 0; x < width; ++x) {
+        const int i = offset[x];
+        dst[x] = qPremultiply(qRgba(float2uchar(srcR[i]), float2uchar(srcG[i]), float2uchar(srcB[i]), float2uchar(srcA[i])));
+      }
+    } else {
+      for (int x = 0; x < width; ++x) {
+        const int i = offset[x];
+        dst[x] = qRgb(float2uchar(srcR[i]), float2uchar(srcG[i]), float2uchar(srcB[i]));
+      }
+    }
+  } else {
+    const float * src = in.data(0, sourceY, 0, 0);
+    if (in.spectrum() == 2) {
+      const float * srcA = in.data(0, sourceY, 0, 1);
+      for (int x = 0; x < width; ++x) {
+        const int i = offset[x];
+        const unsigned char gray = float2uchar(src[i]);
+        dst[x] = qPremultiply(qRgba(gray, gray, gray, float2uchar(srcA[i])));
       }
     } else {
-      for (int y = 0; y < h; ++y) {
-        const unsigned char * src = in.scanLine(y);
-        int n = in.width();
-        while (n--) {
-          *dstA++ = static_cast<float>(src[0]);
-          *dstR++ = static_cast<float>(src[1]);
-          *dstG++ = static_cast<float>(src[2]);
-          *dstB++ = static_cast<float>(src[3]);
-          src += 4;
-        }
+      for (int x = 0; x < width; ++x) {
+        const unsigned char gray = float2uchar(src[offset[x]]);
+        dst[x] = qRgb(gray, gray, gray);
       }
     }
+  }
+}
+}
+
+void ImageConverter::convert(const cimg_library::CImg<float> & in, QImage & out)
+{
+  Q_ASSERT_X(in.spectrum() <= 4, "ImageConverter::convert()", QString("bad input spectrum (%1)").arg(in.spectrum()).toLatin1());
+  ;
+
+  out = QImage(in.width(), in.height(), QImage::Format_RGB888);
+
+  if (in.spectrum() == 4 && out.format() != QImage::Format_ARGB32) {
+    out = out.convertToFormat(QImage::Format_ARGB32);
+  }
+
+  if (in.spectrum() == 3 && out.format() != QImage::Format_RGB888) {
+    out = out.convertToFormat(QImage::Format_RGB888);
+  }
+
+  if (in.spectrum() == 2 && out.format() != QImage::Format_ARGB32) {
+    out = out.convertToFormat(QImage::Format_ARGB32);
+  }
+
+// Format_Grayscale8 was added in Qt 5.5.
+#if ((QT_VERSION_MAJOR == 5) && (QT_VERSION_MINOR > 4)) || (QT_VERSION_MAJOR >= 6)
+  if (in.spectrum() == 1 && out.format() != QImage::Format_Grayscale8) {
+    out = out.convertToFormat(QImage::Format_Grayscale8);
+  }
+#else
+  if (in.spectrum() == 1) {
+    out = out.convertToFormat(QImage::Format_RGB888);
+  }
+#endif
+
+  const int height = out.height();
+  const bool littleEndian = archIsLittleEndian();
+  // QImage::scanLine() may detach, which is not thread-safe: get the buffer once
+  unsigned char * const bits = out.bits();
+  const int bytesPerLine = out.bytesPerLine();
+#ifdef cimg_use_openmp
+#pragma omp parallel for if (in.width() * in.height() >= PARALLEL_CONVERSION_MIN_PIXELS)
+#endif
+  for (int y = 0; y < height; ++y) {
+    convertRow(in, y, bits + y * bytesPerLine, littleEndian);
+  }
+}
+
+void ImageConverter::convert(const QImage & in, cimg_library::CImg<float> & out)
+{
+  Q_ASSERT_X(in.format() == QImage::Format_ARGB32 || in.format() == QImage::Format_RGB888, "convert", "bad input format");
+  if (in.format() != QImage::Format_ARGB32 && in.format() != QImage::Format_RGB888) {
     return;
   }
+  const int h = in.height();
+  out.assign(in.width(), h, 1, (in.format() == QImage::Format_ARGB32) ? 4 : 3);
+  const bool littleEndian = archIsLittleEndian();
+#ifdef cimg_use_openmp
+#pragma omp parallel for if (in.width() * in.height() >= PARALLEL_CONVERSION_MIN_PIXELS)
+#endif
+  for (int y = 0; y < h; ++y) {
+    convertRow(in.scanLine(y), out, y, littleEndian);
+  }
+}
 
-  if (in.format() == QImage::Format_RGB888) {
-    const int w = in.width();
-    const int h = in.height();
-    out.assign(w, h, 1, 3);
-    float * dstR = out.data(0, 0, 0, 0);
-    float * dstG = out.data(0, 0, 0, 1);
-    float * dstB = out.data(0, 0, 0, 2);
-    for (int y = 0; y < h; ++y) {
-      const unsigned char * src = in.scanLine(y);
-      int n = in.width();
-      while (n--) {
-        *dstR++ = static_cast<float>(src[0]);
-        *dstG++ = static_cast<float>(src[1]);
-        *dstB++ = static_cast<float>(src[2]);
-        src += 3;
-      }
-    }
+void ImageConverter::convert(const cimg_library::CImg<float> & in, QImage & out, const QSize & size)
+{
+  Q_ASSERT_X(in.spectrum() <= 4, "ImageConverter::convert()", QString("bad input spectrum (%1)").arg(in.spectrum()).toLatin1());
+  if (in.is_empty() || size.isEmpty()) {
+    out = QImage();
     return;
   }
+  const bool hasAlpha = (in.spectrum() == 2) || (in.spectrum() == 4);
+  const QImage::Format format = hasAlpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+  if ((out.size() != size) || (out.format() != format)) {
+    out = QImage(size, format);
+  }
+  const int width = size.width();
+  const int height = size.height();
+  // Same source pixels as CImg::resize() with nearest neighbor interpolation
+  std::vector<int> xOffsets(width);
+  for (int x = 0; x < width; ++x) {
+    xOffsets[x] = static_cast<int>((static_cast<long long>(x) * in.width()) / width);
+  }
+  unsigned char * const bits = out.bits();
+  const int bytesPerLine = out.bytesPerLine();
+#ifdef cimg_use_openmp
+#pragma omp parallel for if (width * height >= PARALLEL_CONVERSION_MIN_PIXELS)
+#endif
+  for (int y = 0; y < height; ++y) {
+    const int sourceY = static_cast<int>((static_cast<long long>(y) * in.height()) / height);
+    convertDisplayRow(in, sourceY, xOffsets, reinterpret_cast<QRgb *>(bits + y * bytesPerLine));
+  }
 }
@@ -26,6 +26,7 @@
 #define _GMIC_QT_IMAGECONVERTER_H_
 
 class QImage;
+class QSize;
 namespace cimg_library
 {
 template <typename T> struct CImg;
@@ -35,6 +36,12 @@ class ImageConverter {
 public:
   static void convert(const cimg_library::CImg<float> & in, QImage & out);
   static void convert(const QImage & in, cimg_library::CImg<float> & out);
+  /**
+   * @brief Resize (nearest neighbor) and convert an image in a single pass,
+   *        to a format painted without further conversion (RGB32, or
+   *        ARGB32_Premultiplied if the image has an alpha channel).
+   */
+  static void convert(const cimg_library::CImg<float> & in, QImage & out, const QSize & size);
 
 private:
   ImageConverter() = delete;
@@ -0,0 +1,183 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ImagePyramid.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ImagePyramid.h"
+#include <algorithm>
+#include <cmath>
+#include "Host/host.h"
+#include "gmic.h"
+
+namespace
+{
+// Pixels fetched from the host per event loop iteration
+const int BandPixels = 1 << 20;
+}
+
+ImagePyramid::ImagePyramid(GmicQt::InputMode mode, QObject * parent) : QObject(parent), _inputMode(mode), _fullSize(-1, -1), _loaded(false), _nextRow(-1)
+{
+  _bandTimer.setSingleShot(true);
+  _bandTimer.setInterval(0);
+  connect(&_bandTimer, SIGNAL(timeout()), this, SLOT(loadNextBand()));
+}
+
+ImagePyramid::~ImagePyramid()
+{
+  clear();
+}
+
+void ImagePyramid::clear()
+{
+  _bandTimer.stop();
+  qDeleteAll(_levels);
+  _levels.clear();
+  _fullSize = QSize(-1, -1);
+  _loaded = false;
+  _nextRow = -1;
+}
+
+QSize ImagePyramid::size()
+{
+  if (!_fullSize.isValid()) {
+    int width = 0;
+    int height = 0;
+    gmic_qt_get_layers_extent(&width, &height, _inputMode);
+    _fullSize = QSize(std::max(0, width), std::max(0, height));
+  }
+  return _fullSize;
+}
+
+bool ImagePyramid::isLoaded() const
+{
+  return _loaded;
+}
+
+void ImagePyramid::startLoading()
+{
+  if (_loaded || (_nextRow >= 0)) {
+    return;
+  }
+  _nextRow = 0;
+  _bandTimer.start();
+}
+
+QRect ImagePyramid::cropRect(double x, double y, double width, double height)
+{
+  const QSize fullSize = size();
+  const int ix = static_cast<int>(std::floor(x * fullSize.width()));
+  const int iy = static_cast<int>(std::floor(y * fullSize.height()));
+  const int iw = std::min(fullSize.width() - ix, static_cast<int>(1 + std::ceil(width * fullSize.width())));
+  const int ih = std::min(fullSize.height() - iy, static_cast<int>(1 + std::ceil(height * fullSize.height())));
+  return QRect(ix, iy, std::max(0, iw), std::max(0, ih));
+}
+
+void ImagePyramid::getCrop(double x, double y, double width, double height, const QSize & displaySize, cimg_library::CImg<float> & crop)
+{
+  const QRect rect = cropRect(x, y, width, height);
+  if (!_loaded || _levels.isEmpty() || rect.isEmpty()) {
+    startLoading();
+    crop.assign();
+    return;
+  }
+  int index = 0;
+  while (((rect.width() >> (index + 1)) >= displaySize.width()) && ((rect.height() >> (index + 1)) >= displaySize.height()) && //
+         (level(index).width() > 1) && (level(index).height() > 1)) {
+    ++index;
+  }
+  const cimg_library::CImg<unsigned char> & image = level(index);
+  const int x0 = std::min(rect.x() >> index, image.width() - 1);
+  const int y0 = std::min(rect.y() >> index, image.height() - 1);
+  const int x1 = std::min((rect.right() + 1 + (1 << index) - 1) >> index, image.width()) - 1;
+  const int y1 = std::min((rect.bottom() + 1 + (1 << index) - 1) >> index, image.height()) - 1;
+  crop = image.get_crop(x0, y0, std::max(x0, x1), std::max(y0, y1));
+}
+
+void ImagePyramid::loadNextBand()
+{
+  const QSize fullSize = size();
+  if ((_nextRow < 0) || fullSize.isEmpty()) {
+    _nextRow = -1;
+    return;
+  }
+  int bandHeight = std::min(fullSize.height() - _nextRow, std::max(1, BandPixels / std::max(1, fullSize.width())));
+  gmic_list<float> images;
+  gmic_list<char> imageNames;
+  if (bandHeight < fullSize.height()) {
+    // Quarter-pixel offset: the first row of the band, whether the host floors or rounds
+    gmic_qt_get_cropped_images(images, imageNames, 0.0, (_nextRow + 0.25) / fullSize.height(), 1.0, bandHeight / double(fullSize.height()), _inputMode);
+  }
+  if (!images.size() || (images[0].width() != fullSize.width()) || (images[0].height() < bandHeight)) {
+    // Single band, or host crops not matching the layers extent: fetch the whole image
+    gmic_qt_get_cropped_images(images, imageNames, -1.0, -1.0, -1.0, -1.0, _inputMode);
+    qDeleteAll(_levels);
+    _levels.clear();
+    if (!images.size() || images[0].is_empty()) {
+      _nextRow = -1;
+      return;
+    }
+    _fullSize = QSize(images[0].width(), images[0].height());
+    _nextRow = 0;
+    bandHeight = _fullSize.height();
+  }
+  cimg_library::CImg<float> & band = images[0];
+  gmic_qt_apply_color_profile(band);
+  if (!_levels.isEmpty() && (_levels.front()->spectrum() != band.spectrum())) {
+    // The host image changed meanwhile: start over
+    qDeleteAll(_levels);
+    _levels.clear();
+    _nextRow = 0;
+    _bandTimer.start();
+    return;
+  }
+  if (_levels.isEmpty()) {
+    _levels.push_back(new cimg_library::CImg<unsigned char>(_fullSize.width(), _fullSize.height(), 1, band.spectrum()));
+  }
+  cimg_library::CImg<unsigned char> & image = *_levels.front();
+  const int width = image.width();
+  for (int c = 0; c < image.spectrum(); ++c) {
+    for (int row = 0; row < bandHeight; ++row) {
+      const float * src = band.data(0, row, 0, c);
+      unsigned char * dst = image.data(0, _nextRow + row, 0, c);
+      for (int x = 0; x < width; ++x) {
+        dst[x] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, src[x])));
+      }
+    }
+  }
+  _nextRow += bandHeight;
+  if (_nextRow < image.height()) {
+    _bandTimer.start();
+    return;
+  }
+  _nextRow = -1;
+  _loaded = true;
+  emit loaded();
+}
+
+const cimg_library::CImg<unsigned char> & ImagePyramid::level(int index)
+{
+  while (_levels.size() <= index) {
+    const cimg_library::CImg<unsigned char> & finer = *_levels.back();
+    _levels.push_back(new cimg_library::CImg<unsigned char>(finer.get_resize(std::max(1, finer.width() / 2), std::max(1, finer.height() / 2), 1, -100, 2)));
+  }
+  return *_levels[index];
+}
@@ -0,0 +1,87 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ImagePyramid.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_IMAGEPYRAMID_H_
+#define _GMIC_QT_IMAGEPYRAMID_H_
+
+#include <QList>
+#include <QObject>
+#include <QRect>
+#include <QSize>
+#include <QTimer>
+#include "gmic_qt.h"
+
+namespace cimg_library
+{
+template <typename T> struct CImg;
+}
+
+/**
+ * @brief Mipmap pyramid (1, 1/2, 1/4, ...) of a host image, used to display
+ *        the original image at any zoom level without host round-trips.
+ *        The full resolution image is fetched once, by bands of rows converted
+ *        straight to 8 bits per channel, from the event loop so that painting
+ *        never waits for the host. Coarser levels are built lazily.
+ */
+class ImagePyramid : public QObject {
+  Q_OBJECT
+public:
+  ImagePyramid(GmicQt::InputMode mode = GmicQt::Active, QObject * parent = nullptr);
+  ~ImagePyramid();
+  void clear();
+  QSize size();
+  bool isLoaded() const;
+  /**
+   * @brief Start fetching the host image, if not already done or in progress.
+   */
+  void startLoading();
+  /**
+   * @brief Pixel area of the full resolution image covered by a normalized
+   *        rectangle (same rounding as the hosts' gmic_qt_get_cropped_images()).
+   */
+  QRect cropRect(double x, double y, double width, double height);
+  /**
+   * @brief Get the crop of a normalized rectangle from the coarsest level whose
+   *        resolution is still at least that of displaySize.
+   *        The crop is empty until the image is loaded.
+   */
+  void getCrop(double x, double y, double width, double height, const QSize & displaySize, cimg_library::CImg<float> & crop);
+
+signals:
+  void loaded();
+
+private slots:
+  void loadNextBand();
+
+private:
+  const cimg_library::CImg<unsigned char> & level(int index);
+  GmicQt::InputMode _inputMode;
+  QSize _fullSize;
+  bool _loaded;
+  int _nextRow;
+  QTimer _bandTimer;
+  QList<cimg_library::CImg<unsigned char> *> _levels;
+};
+
+#endif // _GMIC_QT_IMAGEPYRAMID_H_
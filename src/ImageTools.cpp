@@ -25,7 +25,9 @@
 #include "ImageTools.h"
 #include <QImage>
 #include <QPainter>
+#include <algorithm>
 #include "GmicStdlib.h"
+#include "Globals.h"
 #include "ImageConverter.h"
 #include "gmic.h"
 
@@ -113,6 +115,41 @@ void buildPreviewImage(const cimg_library::CImgList<float> & images, cimg_librar
 
 template <typename T> void image2uchar(cimg_library::CImg<T> & img)
 {
+#ifdef cimg_use_openmp
+  // In place and in parallel, by waves of rows: the bytes written for rows
+  // [first,last[ only cover the first channel of rows already converted by
+  // previous waves, or the current row's own pixels (read before written).
+  // Other channels are never overwritten since at most 4 bytes are written
+  // per 4-byte pixel value.
+  if ((sizeof(T) >= 4) && (img.spectrum() >= 1) && (img.spectrum() <= 4) && (img.width() * img.height() >= PARALLEL_CONVERSION_MIN_PIXELS)) {
+    const int width = img.width();
+    const int height = img.height();
+    const int spectrum = img.spectrum();
+    int first = 0;
+    while (first < height) {
+      const int last = (spectrum == 4) ? height : std::min(height, std::max(first + 1, (4 * first) / spectrum));
+#pragma omp parallel for
+      for (int y = first; y < last; ++y) {
+        const T * src[4];
+        for (int c = 0; c < spectrum; ++c) {
+          src[c] = img.data(0, y, 0, c);
+        }
+        unsigned char * dst = reinterpret_cast<unsigned char *>(img.data()) + static_cast<size_t>(y) * width * spectrum;
+        for (int x = 0; x < width; ++x) {
+          unsigned char pixel[4];
+          for (int c = 0; c < spectrum; ++c) {
+            pixel[c] = static_cast<unsigned char>(src[c][x]);
+          }
+          for (int c = 0; c < spectrum; ++c) {
+            *dst++ = pixel[c];
+          }
+        }
+      }
+      first = last;
+    }
+    return;
+  }
+#endif
   unsigned int len = img.width() * img.height();
   unsigned char * dst = reinterpret_cast<unsigned char *>(img.data());
   switch (img.spectrum()) {
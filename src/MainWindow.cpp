@@ -39,7 +39,9 @@
 #include <typeinfo>
 #include "Common.h"
 #include "DialogSettings.h"
+#include "FilterParameters/ParametersSchema.h"
 #include "FilterSelector/FavesModelReader.h"
+#include "FilterSelector/FiltersCatalogueThread.h"
 #include "FilterSelector/FiltersPresenter.h"
 #include "FilterSelector/FiltersVisibilityMap.h"
 #include "Globals.h"
@@ -47,6 +49,7 @@
 #include "LayersExtentProxy.h"
 #include "Logger.h"
 #include "ParametersCache.h"
+#include "PreviewCache.h"
 #include "Updater.h"
 #include "Utils.h"
 #include "ui_mainwindow.h"
@@ -63,6 +66,11 @@ MainWindow::MainWindow(QWidget * parent) : QWidget(parent), ui(new Ui::MainWindo
   TIMING;
   _messageTimerID = 0;
   _gtkFavesShouldBeImported = false;
+  _filtersCatalogueThread = 0;
+  _queuedFiltersUpdate = false;
+  _queuedFiltersUpdateAgeLimit = 0;
+  _queuedFiltersUpdateUseNetwork = false;
+  _startupFiltersTreeBuild = false;
 
   setWindowTitle(GmicQt::pluginFullName());
 
@@ -241,6 +249,21 @@ void MainWindow::setDarkTheme()
 
 void MainWindow::updateFiltersFromSources(int ageLimit, bool useNetwork)
 {
+  if (_filtersCatalogueThread) {
+    // The sources are being read by the catalogue thread: update them once
+    // it is done (see onFiltersCatalogueReady())
+    if (_queuedFiltersUpdate) {
+      _queuedFiltersUpdateAgeLimit = std::min(_queuedFiltersUpdateAgeLimit, ageLimit);
+      _queuedFiltersUpdateUseNetwork = _queuedFiltersUpdateUseNetwork || useNetwork;
+    } else {
+      _queuedFiltersUpdate = true;
+      _queuedFiltersUpdateAgeLimit = ageLimit;
+      _queuedFiltersUpdateUseNetwork = useNetwork;
+    }
+    ui->tbUpdateFilters->setEnabled(false);
+    showMessage(tr("Filter definitions will be updated once loaded."), 3000);
+    return;
+  }
   if (useNetwork) {
     ui->progressInfoWidget->startFiltersUpdateAnimationAndShow();
   }
@@ -267,21 +290,38 @@ void MainWindow::onUpdateDownloadsFinished(int status)
   }
 
   buildFiltersTree();
-  ui->tbUpdateFilters->setEnabled(true);
-  if (!_filtersPresenter->currentFilter().hash.isEmpty()) {
-    ui->previewWidget->sendUpdateRequest();
-  }
 }
 
 void MainWindow::buildFiltersTree()
 {
+  // The stdlib and the filters model are built by a worker thread, the
+  // window is updated by onFiltersCatalogueReady() once they are available.
+  ui->tbUpdateFilters->setEnabled(false);
+  _filtersCatalogueThread = new FiltersCatalogueThread(this);
+  connect(_filtersCatalogueThread, SIGNAL(finished()), this, SLOT(onFiltersCatalogueReady()));
+  _filtersCatalogueThread->start();
+}
+
+void MainWindow::onFiltersCatalogueReady()
+{
+  TIMING;
+  FiltersModel filtersModel;
+  _filtersCatalogueThread->takeFiltersModel(filtersModel);
+  QByteArray stdlib = _filtersCatalogueThread->takeStdlib();
+  _filtersCatalogueThread->deleteLater();
+  _filtersCatalogueThread = 0;
+
+  // Swap the new catalogue in. The current filter is selected again by its hash,
+  // with the parameters saved right before the swap.
   saveCurrentParameters();
-  GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+  GmicStdLib::Array = stdlib;
+  PreviewCache::clear();
+  ParametersSchema::clearCache();
   const bool withVisibility = filtersSelectionMode();
 
   // TODO : Is this the right place?
   _filtersPresenter->clear();
-  _filtersPresenter->readFilters();
+  _filtersPresenter->swapFiltersModel(filtersModel);
   _filtersPresenter->readFaves();
   if (_gtkFavesShouldBeImported) {
     _filtersPresenter->importGmicGTKFaves();
@@ -299,6 +339,19 @@ void MainWindow::buildFiltersTree()
     ui->previewWidget->sendUpdateRequest();
   } else {
     activateFilter(false);
+    if (!_startupFiltersTreeBuild) {
+      ui->previewWidget->sendUpdateRequest();
+    }
+  }
+  if (_startupFiltersTreeBuild) {
+    _startupFiltersTreeBuild = false;
+    selectStartupFilter();
+  }
+  if (_queuedFiltersUpdate) {
+    _queuedFiltersUpdate = false;
+    updateFiltersFromSources(_queuedFiltersUpdateAgeLimit, _queuedFiltersUpdateUseNetwork);
+  } else {
+    ui->tbUpdateFilters->setEnabled(true);
   }
 }
 
@@ -321,10 +374,13 @@ void MainWindow::onStartupFiltersUpdateFinished(int status)
   } else {
     _gtkFavesShouldBeImported = askUserForGTKFavesImport();
   }
+  _startupFiltersTreeBuild = true;
   buildFiltersTree();
-
   ui->searchField->setFocus();
+}
 
+void MainWindow::selectStartupFilter()
+{
   // Retrieve and select previously selected filter
   QString hash = QSettings().value("SelectedFilter", QString()).toString();
   if (_newSession || !_lastExecutionOK) {
@@ -466,6 +522,7 @@ void MainWindow::makeConnections()
   connect(ui->pbFullscreen, SIGNAL(toggled(bool)), this, SLOT(onToggleFullScreen(bool)));
 
   connect(ui->filterParams, SIGNAL(valueChanged()), ui->previewWidget, SLOT(sendUpdateRequest()));
+  connect(ui->filterParams, SIGNAL(valueChanging()), this, SLOT(onSpeculativePreviewRequested()));
 
   connect(ui->previewWidget, SIGNAL(previewUpdateRequested()), this, SLOT(onPreviewUpdateRequested()));
 
@@ -491,6 +548,7 @@ void MainWindow::makeConnections()
   connect(ui->tbSelectionMode, SIGNAL(toggled(bool)), this, SLOT(onFiltersSelectionModeToggled(bool)));
 
   connect(&_processor, SIGNAL(previewImageAvailable()), this, SLOT(onPreviewImageAvailable()));
+  connect(&_processor, SIGNAL(speculativePreviewImageAvailable()), this, SLOT(onSpeculativePreviewImageAvailable()));
   connect(&_processor, SIGNAL(previewCommandFailed(QString)), this, SLOT(onPreviewError(QString)));
   connect(&_processor, SIGNAL(fullImageProcessingFailed(QString)), this, SLOT(onFullImageProcessingError(QString)));
   connect(&_processor, SIGNAL(fullImageProcessingDone()), this, SLOT(onFullImageProcessingDone()));
@@ -508,8 +566,24 @@ void MainWindow::onPreviewUpdateRequested()
     return;
   }
   ui->tbUpdateFilters->setEnabled(false);
+  _processor.setContext(previewContext());
+  _processor.execute();
 
-  const FiltersPresenter::Filter currentFilter = _filtersPresenter->currentFilter();
+  ui->filterParams->clearButtonParameters();
+  _okButtonShouldApply = true;
+}
+
+void MainWindow::onSpeculativePreviewRequested()
+{
+  if (!ui->cbPreview->isChecked() || _filtersPresenter->currentFilter().isNoFilter()) {
+    return;
+  }
+  _processor.speculate(previewContext());
+}
+
+GmicProcessor::FilterContext MainWindow::previewContext() const
+{
+  const FiltersPresenter::Filter & currentFilter = _filtersPresenter->currentFilter();
   GmicProcessor::FilterContext context;
   context.requestType = GmicProcessor::FilterContext::PreviewProcessing;
   GmicProcessor::FilterContext::VisibleRect & rect = context.visibleRect;
@@ -523,11 +597,11 @@ void MainWindow::onPreviewUpdateRequested()
   context.filterName = currentFilter.plainTextName;
   context.filterCommand = currentFilter.previewCommand;
   context.filterArguments = ui->filterParams->valueString();
-  _processor.setContext(context);
-  _processor.execute();
-
-  ui->filterParams->clearButtonParameters();
-  _okButtonShouldApply = true;
+  context.progressivePreview = DialogSettings::progressivePreview();
+  context.tiledProcessing = false;
+  context.tileSize = 0;
+  context.tileHalo = 0;
+  return context;
 }
 
 void MainWindow::onPreviewImageAvailable()
@@ -535,12 +609,21 @@ void MainWindow::onPreviewImageAvailable()
   ui->filterParams->setValues(_processor.gmicStatus(), false);
   ui->previewWidget->setPreviewImage(_processor.previewImage());
   ui->previewWidget->enableRightClick();
+  if (_processor.isProcessing()) {
+    return; // Intermediate image of a progressive preview
+  }
   ui->tbUpdateFilters->setEnabled(true);
   if (_pendingActionAfterCurrentProcessing == CloseAction) {
     close();
   }
 }
 
+void MainWindow::onSpeculativePreviewImageAvailable()
+{
+  // Parameters are not updated from the status while the user is dragging a slider
+  ui->previewWidget->setPreviewImage(_processor.previewImage());
+}
+
 void MainWindow::onPreviewError(QString message)
 {
   ui->previewWidget->setPreviewErrorMessage(message);
@@ -574,6 +657,10 @@ void MainWindow::processImage()
   context.filterCommand = currentFilter.command;
   ui->filterParams->updateValueString(false); // Required to get up-to-date values of text parameters
   context.filterArguments = ui->filterParams->valueString();
+  context.progressivePreview = false;
+  context.tiledProcessing = DialogSettings::tiledProcessing() && currentFilter.isTileSafe;
+  context.tileSize = DialogSettings::tileSize();
+  context.tileHalo = DialogSettings::tileHalo();
   ui->filterParams->clearButtonParameters();
   _processor.setContext(context);
   _processor.execute();
@@ -52,6 +52,7 @@ class QResizeEvent;
 class Updater;
 class FilterThread;
 class FiltersPresenter;
+class FiltersCatalogueThread;
 
 class MainWindow : public QWidget {
   Q_OBJECT
@@ -73,6 +74,7 @@ public slots:
   void onUpdateDownloadsFinished(int status);
   void onApplyClicked();
   void onPreviewUpdateRequested();
+  void onSpeculativePreviewRequested();
   void onFullImageProcessingDone();
   void expandOrCollapseFolders();
   void search(QString);
@@ -99,6 +101,7 @@ public slots:
   void onFilterSelectionChanged();
   void onEscapeKeyPressed();
   void onPreviewImageAvailable();
+  void onSpeculativePreviewImageAvailable();
   void onPreviewError(QString message);
 
 protected:
@@ -111,6 +114,7 @@ protected:
   void showUpdateErrors();
   void makeConnections();
   void processImage();
+  GmicProcessor::FilterContext previewContext() const;
   void activateFilter(bool resetZoom);
   void setNoFilter();
   void setPreviewPosition(PreviewPosition position);
@@ -120,6 +124,7 @@ protected:
 private slots:
 
   void onFullImageProcessingError(QString message);
+  void onFiltersCatalogueReady();
 
 private:
   bool filtersSelectionMode();
@@ -134,6 +139,7 @@ private:
   };
   bool askUserForGTKFavesImport();
   void buildFiltersTree();
+  void selectStartupFilter();
 
   enum ProcessingAction
   {
@@ -157,6 +163,11 @@ private:
   bool _gtkFavesShouldBeImported;
   QVector<QWidget *> _filterUpdateWidgets;
   FiltersPresenter * _filtersPresenter;
+  FiltersCatalogueThread * _filtersCatalogueThread;
+  bool _queuedFiltersUpdate;
+  int _queuedFiltersUpdateAgeLimit;
+  bool _queuedFiltersUpdateUseNetwork;
+  bool _startupFiltersTreeBuild;
   GmicProcessor _processor;
 };
 
@@ -30,6 +30,7 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <iostream>
 #include "Globals.h"
 #include "Utils.h"
@@ -37,16 +38,31 @@
 
 QHash<QString, QList<QString>> ParametersCache::_parametersCache;
 QHash<QString, GmicQt::InputOutputState> ParametersCache::_inOutPanelStates;
+QSet<QString> ParametersCache::_modifiedHashes;
+int ParametersCache::_journalRecordCount = 0;
+bool ParametersCache::_snapshotIsObsolete = false;
+quint32 ParametersCache::_generation = 0;
+bool ParametersCache::_journalIsCurrent = false;
+const QString ParametersCache::GenerationKey = QString("generation");
+const quint32 ParametersCache::JournalMagic = 0x676D706A; // "gmpj"
+const qint32 ParametersCache::JournalVersion = 2;
 
 void ParametersCache::load(bool loadFiltersParameters)
 {
   // Load JSON file
   _parametersCache.clear();
   _inOutPanelStates.clear();
+  _modifiedHashes.clear();
+  _journalRecordCount = 0;
+  _generation = 0;
+  _journalIsCurrent = false;
+  // Parameters that are not loaded must not survive in the files either
+  _snapshotIsObsolete = !loadFiltersParameters;
 
   QString jsonFilename = QString("%1%2").arg(GmicQt::path_rc(true), PARAMETERS_CACHE_FILENAME);
   QFile jsonFile(jsonFilename);
   if (!jsonFile.exists()) {
+    loadJournal(loadFiltersParameters);
     return;
   }
   if (jsonFile.open(QFile::ReadOnly)) {
@@ -54,11 +70,13 @@ void ParametersCache::load(bool loadFiltersParameters)
     if (jsonDoc.isNull()) {
       std::cerr << "[gmic-qt] Warning: cannot parse " << jsonFilename.toStdString() << std::endl;
       std::cerr << "[gmic-qt] Last filters parameters are lost!\n";
+      _snapshotIsObsolete = true;
     } else {
       if (!jsonDoc.isObject()) {
         std::cerr << "[gmic-qt] Error: JSON file format is not correct (" << jsonFilename.toStdString() << ")\n";
       } else {
         QJsonObject documentObject = jsonDoc.object();
+        _generation = static_cast<quint32>(documentObject.take(GenerationKey).toDouble(0));
         QJsonObject::iterator itFilter = documentObject.begin();
         while (itFilter != documentObject.end()) {
           QString hash = itFilter.key();
@@ -89,13 +107,136 @@ void ParametersCache::load(bool loadFiltersParameters)
     std::cerr << "[gmic-qt] Error: Cannot read " << jsonFilename.toStdString() << std::endl;
     std::cerr << "[gmic-qt] Parameters cannot be restored.\n";
   }
+  loadJournal(loadFiltersParameters);
+}
+
+void ParametersCache::loadJournal(bool loadFiltersParameters)
+{
+  // The journal holds the entries modified since the snapshot was written,
+  // as a sequence of size-prefixed records (a truncated last record is ignored).
+  QFile file(QString("%1%2").arg(GmicQt::path_rc(false), PARAMETERS_CACHE_JOURNAL_FILENAME));
+  if (!file.open(QFile::ReadOnly)) {
+    _journalIsCurrent = !file.exists();
+    return;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  quint32 magic;
+  qint32 version;
+  quint32 generation = 0; // Version 1 journals were written for snapshots without generation
+  stream >> magic >> version;
+  if (version == JournalVersion) {
+    stream >> generation;
+  }
+  if ((stream.status() != QDataStream::Ok) || (magic != JournalMagic) || (version < 1) || (version > JournalVersion)) {
+    std::cerr << "[gmic-qt] Warning: ignoring " << file.fileName().toStdString() << std::endl;
+    _snapshotIsObsolete = true;
+    return;
+  }
+  if (generation != _generation) {
+    // Left over by a compaction interrupted before the journal was removed:
+    // its entries are already in the snapshot, possibly with newer values.
+    _snapshotIsObsolete = true;
+    return;
+  }
+  _journalIsCurrent = true;
+  QByteArray record;
+  while (!stream.atEnd()) {
+    stream >> record;
+    if (stream.status() != QDataStream::Ok) {
+      _snapshotIsObsolete = true; // Do not append after a damaged record
+      break;
+    }
+    QDataStream recordStream(record);
+    recordStream.setVersion(QDataStream::Qt_5_0);
+    QString hash;
+    bool hasParameters;
+    QList<QString> parameters;
+    QByteArray state;
+    recordStream >> hash >> hasParameters >> parameters >> state;
+    if (recordStream.status() != QDataStream::Ok) {
+      _snapshotIsObsolete = true;
+      break;
+    }
+    if (loadFiltersParameters) {
+      if (hasParameters) {
+        _parametersCache[hash] = parameters;
+      } else {
+        _parametersCache.remove(hash);
+      }
+    }
+    if (state.isEmpty()) {
+      _inOutPanelStates.remove(hash);
+    } else {
+      _inOutPanelStates[hash] = GmicQt::InputOutputState::fromJSONObject(QJsonDocument::fromJson(state).object());
+    }
+    ++_journalRecordCount;
+  }
 }
 
 void ParametersCache::save()
+{
+  // Modified entries are appended to the journal. Once the journal has grown
+  // too long, it is merged into a new snapshot.
+  if (_modifiedHashes.isEmpty() && !_snapshotIsObsolete) {
+    return;
+  }
+  if (!_snapshotIsObsolete && (_journalRecordCount + _modifiedHashes.size() <= MAX_JOURNAL_RECORDS) && appendToJournal()) {
+    return;
+  }
+  if (writeSnapshot()) {
+    QFile::remove(QString("%1%2").arg(GmicQt::path_rc(false), PARAMETERS_CACHE_JOURNAL_FILENAME));
+    _modifiedHashes.clear();
+    _journalRecordCount = 0;
+    _snapshotIsObsolete = false;
+    _journalIsCurrent = false;
+  }
+}
+
+bool ParametersCache::appendToJournal()
+{
+  QFile file(QString("%1%2").arg(GmicQt::path_rc(true), PARAMETERS_CACHE_JOURNAL_FILENAME));
+  // A journal of another generation (or unreadable) is started over
+  const bool newJournal = !_journalIsCurrent || !file.exists() || !file.size();
+  if (!file.open(newJournal ? (QFile::WriteOnly | QFile::Truncate) : (QFile::WriteOnly | QFile::Append))) {
+    return false;
+  }
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  if (newJournal) {
+    stream << JournalMagic << JournalVersion << _generation;
+  }
+  for (const QString & hash : _modifiedHashes) {
+    QByteArray record;
+    QDataStream recordStream(&record, QIODevice::WriteOnly);
+    recordStream.setVersion(QDataStream::Qt_5_0);
+    QByteArray state;
+    QHash<QString, GmicQt::InputOutputState>::const_iterator itState = _inOutPanelStates.find(hash);
+    if (itState != _inOutPanelStates.cend()) {
+      QJsonObject jsonState;
+      itState.value().toJSONObject(jsonState);
+      state = QJsonDocument(jsonState).toJson(QJsonDocument::Compact);
+    }
+    recordStream << hash << _parametersCache.contains(hash) << _parametersCache.value(hash) << state;
+    stream << record;
+  }
+  file.flush();
+  if (stream.status() != QDataStream::Ok) {
+    std::cerr << "[gmic-qt] Error: Cannot write " << file.fileName().toStdString() << std::endl;
+    return false;
+  }
+  _journalIsCurrent = true;
+  _journalRecordCount += _modifiedHashes.size();
+  _modifiedHashes.clear();
+  return true;
+}
+
+bool ParametersCache::writeSnapshot()
 {
   // JSON Document format
   //
   // {
+  //  "generation": 12,
   //  "51d288e6f1c6e531cc61289f17e34d8a": {
   //      "parameters": [
   //          "6",
@@ -147,36 +288,43 @@ void ParametersCache::save()
     ++itParams;
   }
 
+  // A new generation number invalidates the current journal, even if removing it fails
+  const quint32 generation = _generation + 1;
+  documentObject.insert(GenerationKey, static_cast<double>(generation));
+
   QJsonDocument jsonDoc(documentObject);
   QString jsonFilename = QString("%1%2").arg(GmicQt::path_rc(true), PARAMETERS_CACHE_FILENAME);
-  QFile jsonFile(jsonFilename);
-  if (QFile::exists(jsonFilename)) {
-    QString bakFilename = QString("%1%2").arg(GmicQt::path_rc(false), PARAMETERS_CACHE_FILENAME ".bak");
-    QFile::remove(bakFilename);
-    QFile::copy(jsonFilename, bakFilename);
-  }
-  if (jsonFile.open(QFile::WriteOnly | QFile::Truncate)) {
-    qint64 count = jsonFile.write(qCompress(jsonDoc.toBinaryData()));
+  // QSaveFile atomically replaces the previous snapshot, which is kept intact on failure
+  QSaveFile jsonFile(jsonFilename);
+  if (jsonFile.open(QFile::WriteOnly)) {
+    jsonFile.write(qCompress(jsonDoc.toBinaryData()));
     // jsonFile.write(jsonDoc.toJson());
     // jsonFile.write(qCompress(jsonDoc.toBinaryData()));
-    jsonFile.close();
-    if (count != -1) {
+    if (jsonFile.commit()) {
+      _generation = generation;
       // Remove obsolete 2.0.0 pre-release files
       QString path = GmicQt::path_rc(true);
       QFile::remove(path + "gmic_qt_parameters.dat");
       QFile::remove(path + "gmic_qt_parameters.json");
       QFile::remove(path + "gmic_qt_parameters.json.bak");
       QFile::remove(path + "gmic_qt_parameters_json.dat");
+      QFile::remove(path + PARAMETERS_CACHE_FILENAME ".bak");
+      return true;
     }
-  } else {
-    std::cerr << "[gmic-qt] Error: Cannot write " << jsonFilename.toStdString() << std::endl;
-    std::cerr << "[gmic-qt] Parameters cannot be saved.\n";
   }
+  std::cerr << "[gmic-qt] Error: Cannot write " << jsonFilename.toStdString() << std::endl;
+  std::cerr << "[gmic-qt] Parameters cannot be saved.\n";
+  return false;
 }
 
 void ParametersCache::setValues(const QString & hash, const QList<QString> & values)
 {
+  QHash<QString, QList<QString>>::iterator it = _parametersCache.find(hash);
+  if (it != _parametersCache.end() && it.value() == values) {
+    return;
+  }
   _parametersCache[hash] = values;
+  _modifiedHashes.insert(hash);
 }
 
 QList<QString> ParametersCache::getValues(const QString & hash)
@@ -192,6 +340,7 @@ void ParametersCache::remove(const QString & hash)
 {
   _parametersCache.remove(hash);
   _inOutPanelStates.remove(hash);
+  _modifiedHashes.insert(hash);
 }
 
 GmicQt::InputOutputState ParametersCache::getInputOutputState(const QString & hash)
@@ -205,8 +354,14 @@ GmicQt::InputOutputState ParametersCache::getInputOutputState(const QString & ha
 
 void ParametersCache::setInputOutputState(const QString & hash, const GmicQt::InputOutputState & state)
 {
+  // Default states are not stored
+  QHash<QString, GmicQt::InputOutputState>::iterator it = _inOutPanelStates.find(hash);
+  if ((it == _inOutPanelStates.end()) ? state.isDefault() : (it.value() == state)) {
+    return;
+  }
+  _modifiedHashes.insert(hash);
   if (state.isDefault()) {
-    _inOutPanelStates.remove(hash);
+    _inOutPanelStates.erase(it);
     return;
   }
   _inOutPanelStates[hash] = state;
@@ -226,6 +381,7 @@ void ParametersCache::cleanup(const QSet<QString> & hashesToKeep)
   }
   for (const QString & h : obsoleteHashes) {
     _parametersCache.remove(h);
+    _modifiedHashes.insert(h);
   }
   obsoleteHashes.clear();
 
@@ -239,6 +395,7 @@ void ParametersCache::cleanup(const QSet<QString> & hashesToKeep)
   }
   for (const QString & h : obsoleteHashes) {
     _inOutPanelStates.remove(h);
+    _modifiedHashes.insert(h);
   }
   obsoleteHashes.clear();
 }
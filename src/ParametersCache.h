@@ -27,6 +27,7 @@
 
 #include <QHash>
 #include <QList>
+#include <QSet>
 #include <QString>
 #include "InputOutputState.h"
 
@@ -44,8 +45,20 @@ public:
   static void cleanup(const QSet<QString> & hashesToKeep);
 
 private:
+  static void loadJournal(bool loadFiltersParameters);
+  static bool appendToJournal();
+  static bool writeSnapshot();
   static QHash<QString, QList<QString>> _parametersCache;
   static QHash<QString, GmicQt::InputOutputState> _inOutPanelStates;
+  static QSet<QString> _modifiedHashes;
+  static int _journalRecordCount;
+  static bool _snapshotIsObsolete;
+  static quint32 _generation; // Of the snapshot, a journal only applies to the same generation
+  static bool _journalIsCurrent; // The journal file may be appended to
+  static const QString GenerationKey;
+  static const quint32 JournalMagic;
+  static const qint32 JournalVersion;
+  static const int MAX_JOURNAL_RECORDS = 2000;
 };
 
 #endif // _GMIC_QT_PARAMETERSCACHE_H
@@ -0,0 +1,98 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PreviewCache.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "PreviewCache.h"
+#include "gmic.h"
+
+struct PreviewCache::Entry {
+  cimg_library::CImg<float> image;
+  QStringList status;
+  unsigned int randomSeed; // Seed the preview was computed with, to be used by Apply
+};
+
+QCache<QString, PreviewCache::Entry> PreviewCache::_cache(256 * 1024);
+unsigned int PreviewCache::_hits = 0;
+unsigned int PreviewCache::_misses = 0;
+
+bool PreviewCache::find(const QString & key, cimg_library::CImg<float> & image, QStringList & status, unsigned int & randomSeed)
+{
+  Entry * entry = _cache.object(key);
+  if (!entry) {
+    ++_misses;
+    return false;
+  }
+  ++_hits;
+  image = entry->image;
+  status = entry->status;
+  randomSeed = entry->randomSeed;
+  return true;
+}
+
+void PreviewCache::insert(const QString & key, const cimg_library::CImg<float> & image, const QStringList & status, unsigned int randomSeed)
+{
+  if (!_cache.maxCost()) {
+    return;
+  }
+  Entry * entry = new Entry;
+  entry->image = image;
+  entry->status = status;
+  entry->randomSeed = randomSeed;
+  const int kilobytes = static_cast<int>((image.size() * sizeof(float)) / 1024) + 1;
+  _cache.insert(key, entry, kilobytes); // Deletes the entry if too large
+}
+
+void PreviewCache::clear()
+{
+  _cache.clear();
+}
+
+void PreviewCache::setMaxSize(int megabytes)
+{
+  _cache.setMaxCost(1024 * megabytes);
+}
+
+int PreviewCache::maxSize()
+{
+  return _cache.maxCost() / 1024;
+}
+
+int PreviewCache::size()
+{
+  return _cache.totalCost() / 1024;
+}
+
+int PreviewCache::count()
+{
+  return _cache.count();
+}
+
+unsigned int PreviewCache::hits()
+{
+  return _hits;
+}
+
+unsigned int PreviewCache::misses()
+{
+  return _misses;
+}
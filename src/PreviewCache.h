@@ -0,0 +1,65 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PreviewCache.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_PREVIEWCACHE_H_
+#define _GMIC_QT_PREVIEWCACHE_H_
+
+#include <QCache>
+#include <QString>
+#include <QStringList>
+
+namespace cimg_library
+{
+template <typename T> struct CImg;
+}
+
+/**
+ * @brief LRU cache of finished preview images, bounded in memory.
+ *
+ * Keys describe everything a preview depends on (see GmicProcessor).
+ * The cache must be cleared whenever the input image or the filter
+ * definitions change.
+ */
+class PreviewCache {
+public:
+  static bool find(const QString & key, cimg_library::CImg<float> & image, QStringList & status, unsigned int & randomSeed);
+  static void insert(const QString & key, const cimg_library::CImg<float> & image, const QStringList & status, unsigned int randomSeed);
+  static void clear();
+
+  static void setMaxSize(int megabytes);
+  static int maxSize();
+  static int size();
+  static int count();
+  static unsigned int hits();
+  static unsigned int misses();
+
+private:
+  PreviewCache() = delete;
+  struct Entry;
+  static QCache<QString, Entry> _cache; // Cost unit is the kilobyte
+  static unsigned int _hits;
+  static unsigned int _misses;
+};
+
+#endif // _GMIC_QT_PREVIEWCACHE_H_
@@ -23,11 +23,23 @@
  *
  */
 #include "Updater.h"
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QNetworkRequest>
+#include <QPair>
+#include <QSaveFile>
+#include <QStringList>
 #include <QUrl>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <zlib.h>
 #include "Common.h"
+#include "Globals.h"
 #include "GmicStdlib.h"
 #include "Utils.h"
 #include "gmic.h"
@@ -100,45 +112,39 @@ void Updater::updateSources(bool useNetwork)
 
 void Updater::startUpdate(int ageLimit, int timeout, bool useNetwork)
 {
-  TIMING;
   updateSources(useNetwork);
+  startDownloads(ageLimit, timeout, useNetwork);
+}
+
+void Updater::startUpdate(const QList<QString> & sources, int ageLimit, int timeout)
+{
+  _sources = sources;
+  _sourceIsStdLib.clear();
+  startDownloads(ageLimit, timeout, true);
+}
+
+void Updater::startDownloads(int ageLimit, int timeout, bool useNetwork)
+{
+  TIMING;
   _errorMessages.clear();
   _networkAccessManager = new QNetworkAccessManager(this);
   connect(_networkAccessManager, SIGNAL(finished(QNetworkReply *)), this, SLOT(onNetworkReplyFinished(QNetworkReply *)));
   _someNetworkUpdatesAchieved = false;
+  _queuedDownloads.clear();
+  _activeDownloads.clear();
   if (useNetwork) {
     QDateTime limit = QDateTime::currentDateTime().addSecs(-3600 * (qint64)ageLimit);
     for (QString str : _sources) {
-      if (str.startsWith("http://") || str.startsWith("https://")) {
-        QString filename = localFilename(str);
-        QFileInfo info(filename);
-        if (!info.exists() || info.lastModified() < limit) {
-          TRACE << "Downloading" << str << "to" << filename;
-          QUrl url(str);
-          QNetworkRequest request(url);
-          request.setHeader(QNetworkRequest::UserAgentHeader, GmicQt::pluginFullName());
-          // PRIVACY NOTICE (to be displayed in one of the "About" filters of the plugin
-          //
-          // PRIVACY NOTICE
-          // This plugin may download up-to-date filter definitions from the gmic.eu server.
-          // It is the case when first launched after a fresh installation, and periodically
-          // with a frequency which can be set in the settings dialog.
-          // The user should be aware that the following information may be retrieved
-          // from the server logs: IP address of the client; date and time of the request;
-          // as well as a short string, supplied through the HTTP protocol "User Agent" header
-          // field, which describes the full plugin version as shown in the window title
-          // (e.g. "G'MIC-Qt for GIMP 2.8 - Linux 64 bits - 2.2.1_pre#180301").
-          //
-          // Note that this information may solely be used for purely anonymous
-          // statistical purposes.
-          _pendingReplies.insert(_networkAccessManager->get(request));
-        }
+      if ((str.startsWith("http://") || str.startsWith("https://")) && isOutdated(str, limit)) {
+        _queuedDownloads[QUrl(str).host()].append(str);
       }
     }
+    startQueuedDownloads();
   }
   if (_pendingReplies.isEmpty()) {
     emit updateIsDone(UpdateNotNecessary);
     _networkAccessManager->deleteLater();
+    _networkAccessManager = 0;
   } else {
     QTimer::singleShot(timeout * 1000, this, SLOT(cancelAllPendingDownloads()));
   }
@@ -151,9 +157,7 @@ QList<QString> Updater::remotesThatNeedUpdate(int ageLimit) const
   QList<QString> list;
   for (QString str : _sources) {
     if (str.startsWith("http://") || str.startsWith("https://")) {
-      QString filename = localFilename(str);
-      QFileInfo info(filename);
-      if (!info.exists() || info.lastModified() < limit) {
+      if (isOutdated(str, limit)) {
         list << str;
       }
     }
@@ -166,9 +170,7 @@ bool Updater::someUpdatesNeeded(int ageLimit) const
   QDateTime limit = QDateTime::currentDateTime().addSecs(-3600 * ageLimit);
   for (QString str : _sources) {
     if (str.startsWith("http://") || str.startsWith("https://")) {
-      QString filename = localFilename(str);
-      QFileInfo info(filename);
-      if (!info.exists() || info.lastModified() < limit) {
+      if (isOutdated(str, limit)) {
         return true;
       }
     }
@@ -186,14 +188,149 @@ bool Updater::allDownloadsOk() const
   return _errorMessages.isEmpty();
 }
 
+bool Updater::isOutdated(const QString & url, const QDateTime & limit) const
+{
+  // A source is up to date if it was downloaded, or found unchanged on
+  // the server (HTTP 304), after the limit.
+  QFileInfo info(localFilename(url));
+  if (!info.exists()) {
+    return true;
+  }
+  QSettings settings;
+  const QDateTime lastCheck = settings.value(downloadSettingsKey(url, "LastCheck")).toDateTime();
+  return std::max(info.lastModified(), lastCheck) < limit;
+}
+
+QString Updater::downloadSettingsKey(const QString & url, const QString & name)
+{
+  return QString("Updates/%1/%2").arg(QFileInfo(localFilename(url)).fileName()).arg(name);
+}
+
+void Updater::startQueuedDownloads()
+{
+  QMap<QString, QList<QString>>::iterator it = _queuedDownloads.begin();
+  while (it != _queuedDownloads.end()) {
+    while (!it.value().isEmpty() && _activeDownloads[it.key()] < MAX_DOWNLOADS_PER_HOST) {
+      startDownload(it.value().takeFirst());
+    }
+    if (it.value().isEmpty()) {
+      it = _queuedDownloads.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void Updater::startDownload(const QString & str)
+{
+  QString filename = localFilename(str);
+  TRACE << "Downloading" << str << "to" << filename;
+  QUrl url(str);
+  QNetworkRequest request(url);
+  request.setHeader(QNetworkRequest::UserAgentHeader, GmicQt::pluginFullName());
+  // PRIVACY NOTICE (to be displayed in one of the "About" filters of the plugin
+  //
+  // PRIVACY NOTICE
+  // This plugin may download up-to-date filter definitions from the gmic.eu server.
+  // It is the case when first launched after a fresh installation, and periodically
+  // with a frequency which can be set in the settings dialog.
+  // The user should be aware that the following information may be retrieved
+  // from the server logs: IP address of the client; date and time of the request;
+  // as well as a short string, supplied through the HTTP protocol "User Agent" header
+  // field, which describes the full plugin version as shown in the window title
+  // (e.g. "G'MIC-Qt for GIMP 2.8 - Linux 64 bits - 2.2.1_pre#180301").
+  //
+  // Note that this information may solely be used for purely anonymous
+  // statistical purposes.
+
+  QSettings settings;
+  // Conditional request: the server answers 304 if the local file is still valid
+  if (QFileInfo(filename).exists()) {
+    const QByteArray etag = settings.value(downloadSettingsKey(str, "ETag")).toByteArray();
+    const QByteArray lastModified = settings.value(downloadSettingsKey(str, "LastModified")).toByteArray();
+    if (!etag.isEmpty()) {
+      request.setRawHeader("If-None-Match", etag);
+    }
+    if (!lastModified.isEmpty()) {
+      request.setRawHeader("If-Modified-Since", lastModified);
+    }
+  }
+  // Resume an interrupted transfer, provided that the remote file did not change meanwhile
+  const qint64 partSize = QFileInfo(filename + ".part").size();
+  const QByteArray partValidator = settings.value(downloadSettingsKey(str, "PartValidator")).toByteArray();
+  if (partSize > 0 && !partValidator.isEmpty()) {
+    request.setRawHeader("Range", QByteArray("bytes=") + QByteArray::number(partSize) + "-");
+    request.setRawHeader("If-Range", partValidator);
+  }
+
+  QNetworkReply * reply = _networkAccessManager->get(request);
+  connect(reply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
+  _pendingReplies.insert(reply);
+  ++_activeDownloads[url.host()];
+}
+
+void Updater::onReplyReadyRead()
+{
+  QNetworkReply * reply = qobject_cast<QNetworkReply *>(sender());
+  if (reply) {
+    writePartialData(reply);
+  }
+}
+
+bool Updater::writePartialData(QNetworkReply * reply)
+{
+  // Received data goes to a .part file, so that an interrupted download can be resumed
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if ((status != 200 && status != 206) || reply->error() != QNetworkReply::NoError) {
+    reply->readAll();
+    return false;
+  }
+  QFile *& file = _partFiles[reply];
+  if (!file) {
+    const QString url = reply->request().url().toString();
+    file = new QFile(localFilename(url) + ".part", this);
+    if (!file->open(status == 206 ? QFile::Append : (QFile::WriteOnly | QFile::Truncate))) {
+      return false;
+    }
+    QByteArray validator = reply->rawHeader("ETag");
+    if (validator.isEmpty()) {
+      validator = reply->rawHeader("Last-Modified");
+    }
+    QSettings settings;
+    settings.setValue(downloadSettingsKey(url, "PartValidator"), validator);
+  }
+  const QByteArray data = reply->readAll();
+  return file->isOpen() && file->write(data) == data.size();
+}
+
+void Updater::closePartFile(QNetworkReply * reply)
+{
+  QFile * file = _partFiles.take(reply);
+  delete file;
+}
+
 void Updater::processReply(QNetworkReply * reply)
 {
   QString url = reply->request().url().toString();
-  if (!reply->bytesAvailable()) {
+  QString filename = localFilename(url);
+  QSettings settings;
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 304) {
+    TRACE << "Not modified:" << url;
+    settings.setValue(downloadSettingsKey(url, "LastCheck"), QDateTime::currentDateTime());
     return;
   }
-  QByteArray array = reply->readAll();
-  if (array.isNull()) {
+  const bool partOk = writePartialData(reply);
+  closePartFile(reply);
+  QFile part(filename + ".part");
+  QByteArray array;
+  if (partOk && part.open(QFile::ReadOnly)) {
+    array = part.readAll();
+    part.close();
+  }
+  part.remove();
+  settings.remove(downloadSettingsKey(url, "PartValidator"));
+  if (array.isEmpty()) {
     _errorMessages << QString(tr("Error downloading %1 (empty file?)")).arg(url);
     return;
   }
@@ -206,13 +343,23 @@ void Updater::processReply(QNetworkReply * reply)
     _errorMessages << QString(tr("Could not read/decompress %1")).arg(url);
     return;
   }
-  QString filename = localFilename(url);
-  QFile file(filename);
+  settings.setValue(downloadSettingsKey(url, "ETag"), reply->rawHeader("ETag"));
+  settings.setValue(downloadSettingsKey(url, "LastModified"), reply->rawHeader("Last-Modified"));
+  settings.setValue(downloadSettingsKey(url, "LastCheck"), QDateTime::currentDateTime());
+
+  // Leave an identical file untouched (its date is part of the stdlib cache key)
+  QFile current(filename);
+  if (current.size() == array.size() && current.open(QFile::ReadOnly) && current.readAll() == array) {
+    TRACE << "Unchanged:" << filename;
+    return;
+  }
+  current.close();
+  QSaveFile file(filename);
   if (!file.open(QFile::WriteOnly)) {
     _errorMessages << QString(tr("Error creating file %1")).arg(filename);
     return;
   }
-  if (file.write(array) != array.size()) {
+  if (file.write(array) != array.size() || !file.commit()) {
     _errorMessages << QString(tr("Error writing file %1")).arg(filename);
   } else {
     _someNetworkUpdatesAchieved = true;
@@ -225,9 +372,13 @@ void Updater::onNetworkReplyFinished(QNetworkReply * reply)
   if (reply->error() == QNetworkReply::NoError) {
     processReply(reply);
   } else {
+    // Keep the .part file (if any) for the next attempt
+    closePartFile(reply);
     _errorMessages << QString(tr("Error downloading %1")).arg(reply->request().url().toString());
   }
   _pendingReplies.remove(reply);
+  --_activeDownloads[reply->request().url().host()];
+  startQueuedDownloads();
   if (_pendingReplies.isEmpty()) {
     if (_errorMessages.isEmpty()) {
       emit updateIsDone(UpdateSuccessful);
@@ -249,6 +400,13 @@ void Updater::notifyAllDowloadsOK()
 void Updater::cancelAllPendingDownloads()
 {
   TIMING;
+  // Queued downloads are dropped first, so that aborting a reply does not start them
+  for (const QList<QString> & urls : _queuedDownloads) {
+    for (const QString & url : urls) {
+      _errorMessages << QString(tr("Download timeout: %1")).arg(url);
+    }
+  }
+  _queuedDownloads.clear();
   // Make a copy because aborting will call onNetworkReplyFinished, and
   // thus modify the _pendingReplies set.
   QSet<QNetworkReply *> replies = _pendingReplies;
@@ -258,41 +416,103 @@ void Updater::cancelAllPendingDownloads()
   }
 }
 
-QByteArray Updater::cimgzDecompress(QByteArray array)
+namespace
 {
-  QTemporaryFile tmpZ(QDir::tempPath() + QDir::separator() + "gmic_qt_update_XXXXXX_cimgz");
-  if (!tmpZ.open()) {
-    qWarning() << "Updater::cimgzDecompress(): Error creating" << tmpZ.fileName();
-    return QByteArray();
+// Read a line of a .cimg(z) header, moving pos past its '\n'
+bool readCimgHeaderLine(const char * data, qint64 size, qint64 & pos, QByteArray & line)
+{
+  const char * eol = static_cast<const char *>(memchr(data + pos, '\n', static_cast<size_t>(size - pos)));
+  if (!eol) {
+    return false;
   }
-  tmpZ.write(array);
-  tmpZ.flush();
-  tmpZ.close();
-  std::FILE * file = fopen(tmpZ.fileName().toLocal8Bit().constData(), "rb");
-  if (!file) {
-    qWarning() << "Updater::cimgzDecompress(): Error opening" << tmpZ.fileName();
+  line = QByteArray(data + pos, static_cast<int>(eol - data - pos));
+  pos = eol - data + 1;
+  return true;
+}
+} // namespace
+
+QByteArray Updater::cimgzDecompress(const QByteArray & array)
+{
+  // Parse the .cimgz header and inflate the pixel data of each image directly
+  // into the result, instead of going through CImg<>::load_cimg() and a file.
+  // Only 8 bits pixel types are expected (update files are byte buffers).
+  const char * data = array.constData();
+  const qint64 size = array.size();
+  qint64 pos = 0;
+  QByteArray line;
+  do {
+    if (!readCimgHeaderLine(data, size, pos, line)) {
+      qWarning() << "Updater::cimgzDecompress(): Invalid header";
+      return QByteArray();
+    }
+  } while (line.startsWith('#'));
+
+  unsigned int count = 0;
+  char pixelType[256] = {0};
+  if (sscanf(line.constData(), "%u%*c%255[A-Za-z64_]", &count, pixelType) != 2) {
+    qWarning() << "Updater::cimgzDecompress(): Invalid header" << line;
     return QByteArray();
   }
-  cimg_library::CImg<unsigned char> buffer;
-  try {
-    buffer.load_cimg(file);
-  } catch (...) {
-    qWarning() << "Updater::cimgzDecompress(): CImg<>::load_cimg error for file " << tmpZ.fileName();
+  static const QStringList bytePixelTypes = {"char", "uchar", "unsigned_char", "signed_char", "int8", "uint8"};
+  if (!bytePixelTypes.contains(QString(pixelType))) {
+    qWarning() << "Updater::cimgzDecompress(): Unsupported pixel type" << pixelType;
     return QByteArray();
   }
-  return QByteArray((char *)buffer.data(), buffer.size());
+
+  QByteArray result;
+  for (unsigned int n = 0; n < count; ++n) {
+    unsigned int w = 0, h = 0, d = 0, c = 0;
+    unsigned long long compressedSize = 0;
+    if (!readCimgHeaderLine(data, size, pos, line)) {
+      qWarning() << "Updater::cimgzDecompress(): Truncated data";
+      return QByteArray();
+    }
+    const int fields = sscanf(line.constData(), "%u %u %u %u #%llu", &w, &h, &d, &c, &compressedSize);
+    if (fields < 4) {
+      qWarning() << "Updater::cimgzDecompress(): Invalid image header" << line;
+      return QByteArray();
+    }
+    const qint64 imageSize = static_cast<qint64>(w) * h * d * c;
+    if (!imageSize) {
+      continue;
+    }
+    const qint64 inputSize = (fields == 5) ? static_cast<qint64>(compressedSize) : imageSize;
+    if (inputSize > size - pos || result.size() + imageSize > std::numeric_limits<int>::max()) {
+      qWarning() << "Updater::cimgzDecompress(): Truncated data";
+      return QByteArray();
+    }
+    const int offset = result.size();
+    result.resize(offset + static_cast<int>(imageSize));
+    if (fields == 5) {
+      uLongf length = static_cast<uLongf>(imageSize);
+      if (uncompress(reinterpret_cast<Bytef *>(result.data() + offset), &length, reinterpret_cast<const Bytef *>(data + pos), static_cast<uLong>(inputSize)) != Z_OK || length != static_cast<uLongf>(imageSize)) {
+        qWarning() << "Updater::cimgzDecompress(): Decompression error";
+        return QByteArray();
+      }
+    } else {
+      memcpy(result.data() + offset, data + pos, static_cast<size_t>(imageSize));
+    }
+    pos += inputSize;
+  }
+  return result;
 }
 
 QByteArray Updater::cimgzDecompressFile(QString filename)
 {
-  cimg_library::CImg<unsigned char> buffer;
-  try {
-    buffer.load_cimg(filename.toLocal8Bit().constData());
-  } catch (...) {
-    qWarning() << "Updater::cimgzDecompressFile(): CImg<>::load_cimg error for file " << filename;
+  QFile file(filename);
+  if (!file.open(QFile::ReadOnly)) {
+    qWarning() << "Updater::cimgzDecompressFile(): Error opening file " << filename;
     return QByteArray();
   }
-  return QByteArray((char *)buffer.data(), buffer.size());
+  // Decompress from the mapped file when possible, otherwise from a copy in memory
+  const qint64 size = file.size();
+  uchar * map = (size > 0 && size <= std::numeric_limits<int>::max()) ? file.map(0, size) : 0;
+  if (map) {
+    QByteArray result = cimgzDecompress(QByteArray::fromRawData(reinterpret_cast<const char *>(map), static_cast<int>(size)));
+    file.unmap(map);
+    return result;
+  }
+  return cimgzDecompress(file.readAll());
 }
 
 QString Updater::localFilename(QString url)
@@ -320,6 +540,86 @@ QList<QString> Updater::sources() const
 }
 
 QByteArray Updater::buildFullStdlib() const
+{
+  TIMING;
+  const QByteArray key = stdlibCacheKey();
+  QByteArray result = readStdlibCache(key);
+  if (result.isNull()) {
+    result = assembleFullStdlib();
+    writeStdlibCache(key, result);
+  }
+  return result;
+}
+
+QByteArray Updater::stdlibCacheKey() const
+{
+  // The assembled stdlib only depends on the sources and on the local files they refer to
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(GmicQt::gmicVersionString().toUtf8());
+  for (const QString & source : _sources) {
+    QFileInfo info(localFilename(source));
+    hash.addData(QString("\n%1|%2|%3|%4").arg(source).arg(isStdlib(source)).arg(info.exists() ? info.size() : -1).arg(info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0).toUtf8());
+  }
+  return hash.result();
+}
+
+QByteArray Updater::readStdlibCache(const QByteArray & key)
+{
+  // The stdlib is a fromRawData() view of the mapped cache file, which must
+  // stay mapped while copies of the view (e.g. GmicStdLib::Array) are alive.
+  // Mappings of former keys are released as soon as their view is no longer
+  // shared, so at most one mapping per stdlib still in use is kept.
+  // May be called from the thread building the filters catalogue.
+  static QMutex mutex;
+  static QList<QPair<QFile *, QByteArray>> mappings;
+  static QByteArray mappedKey;
+  QMutexLocker locker(&mutex);
+  if (!mappings.isEmpty() && key == mappedKey) {
+    return mappings.back().second;
+  }
+
+  QFile * file = new QFile(QString("%1%2").arg(GmicQt::path_rc(false), STDLIB_CACHE_FILENAME));
+  const qint64 size = file->size();
+  if (size <= key.size() + 1 || size > std::numeric_limits<int>::max() || !file->open(QFile::ReadOnly)) {
+    delete file;
+    return QByteArray();
+  }
+  // File layout: key, stdlib, '\0' (G'MIC reads the stdlib as a C string)
+  const char * data = reinterpret_cast<const char *>(file->map(0, size));
+  if (!data || memcmp(data, key.constData(), key.size()) || data[size - 1]) {
+    delete file;
+    return QByteArray();
+  }
+  for (int i = 0; i < mappings.size();) {
+    if (mappings[i].second.isDetached()) {
+      mappings[i].second.clear();
+      delete mappings[i].first; // Unmaps the file
+      mappings.removeAt(i);
+    } else {
+      ++i;
+    }
+  }
+  mappings.push_back(qMakePair(file, QByteArray::fromRawData(data + key.size(), static_cast<int>(size - key.size() - 1))));
+  mappedKey = key;
+  return mappings.back().second;
+}
+
+void Updater::writeStdlibCache(const QByteArray & key, const QByteArray & stdlib)
+{
+  // QSaveFile replaces the file by a new one, leaving a previous mapping valid
+  QSaveFile file(QString("%1%2").arg(GmicQt::path_rc(true), STDLIB_CACHE_FILENAME));
+  if (!file.open(QFile::WriteOnly)) {
+    qWarning() << "[gmic-qt] Error: Cannot write" << file.fileName();
+    return;
+  }
+  file.write(key);
+  file.write(stdlib.constData(), stdlib.size() + 1);
+  if (!file.commit()) {
+    qWarning() << "[gmic-qt] Error: Cannot write" << file.fileName();
+  }
+}
+
+QByteArray Updater::assembleFullStdlib() const
 {
   QByteArray result;
   if (_sources.isEmpty()) {
@@ -38,7 +38,6 @@
 #include <QSet>
 #include <QSettings>
 #include <QString>
-#include <QTemporaryFile>
 #include <QTimer>
 #include <memory>
 
@@ -69,6 +68,12 @@ public:
    */
   void startUpdate(int ageLimit, int timeout, bool useNetwork);
 
+  /**
+   * @brief Same as above, for the given sources instead of the ones listed
+   *        by G'MIC (used by the tests).
+   */
+  void startUpdate(const QList<QString> & sources, int ageLimit, int timeout);
+
   QList<QString> errorMessages();
   QList<QString> remotesThatNeedUpdate(int ageLimit) const;
   bool someUpdatesNeeded(int ageLimit) const;
@@ -80,11 +85,19 @@ public:
 
   void updateSources(bool useNetwork);
 
+  /**
+   * @brief Concatenated pixel data of the 8-bit images of a .cimgz file,
+   *        inflated in memory (empty on error).
+   */
+  static QByteArray cimgzDecompress(const QByteArray & array);
+  static QByteArray cimgzDecompressFile(QString filename);
+
 signals:
   void updateIsDone(int status);
 
 public slots:
   void onNetworkReplyFinished(QNetworkReply *);
+  void onReplyReadyRead();
   void notifyAllDowloadsOK();
   void cancelAllPendingDownloads();
 
@@ -92,12 +105,22 @@ protected:
   void processReply(QNetworkReply * reply);
 
 private:
+  static const int MAX_DOWNLOADS_PER_HOST = 2;
   static QString localFilename(QString url);
+  static QString downloadSettingsKey(const QString & url, const QString & name);
+  bool isOutdated(const QString & url, const QDateTime & limit) const;
+  void startDownloads(int ageLimit, int timeout, bool useNetwork);
+  void startQueuedDownloads();
+  void startDownload(const QString & url);
+  bool writePartialData(QNetworkReply * reply);
+  void closePartFile(QNetworkReply * reply);
   bool isStdlib(const QString & source) const;
 
   explicit Updater(QObject * parent);
-  static QByteArray cimgzDecompress(QByteArray array);
-  static QByteArray cimgzDecompressFile(QString filename);
+  QByteArray assembleFullStdlib() const;
+  QByteArray stdlibCacheKey() const;
+  static QByteArray readStdlibCache(const QByteArray & key);
+  static void writeStdlibCache(const QByteArray & key, const QByteArray & stdlib);
   static std::unique_ptr<Updater> _instance;
   static GmicQt::OutputMessageMode _outputMessageMode;
 
@@ -105,6 +128,9 @@ private:
   QList<QString> _sources;
   QMap<QString, bool> _sourceIsStdLib;
   QSet<QNetworkReply *> _pendingReplies;
+  QMap<QString, QList<QString>> _queuedDownloads;
+  QMap<QString, int> _activeDownloads;
+  QMap<QNetworkReply *, QFile *> _partFiles;
   QList<QString> _errorMessages;
   bool _someNetworkUpdatesAchieved;
 };
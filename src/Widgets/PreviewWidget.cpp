@@ -41,7 +41,7 @@
 
 const PreviewWidget::PreviewRect PreviewWidget::PreviewRect::Full{0.0, 0.0, 1.0, 1.0};
 
-PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent), _cachedOriginalImage(new gmic_image<float>())
+PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent)
 {
   setAutoFillBackground(false);
   _image = new cimg_library::CImg<float>;
@@ -53,8 +53,6 @@ PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent), _cachedOrigina
   _visibleRect = PreviewRect::Full;
   saveVisibleCenter();
 
-  _cachedOriginalImagePosition = {-1.0, -1.0, -1.0, -1.0};
-
   _pendingResize = false;
   _previewEnabled = true;
   _currentZoomFactor = 1.0;
@@ -64,6 +62,7 @@ PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent), _cachedOrigina
   qApp->installEventFilter(this);
   _rightClickEnabled = false;
   _originalImageSize = QSize(-1, -1);
+  connect(&_originalImagePyramid, SIGNAL(loaded()), this, SLOT(update()));
 }
 
 PreviewWidget::~PreviewWidget()
@@ -81,6 +80,7 @@ void PreviewWidget::setPreviewImage(const cimg_library::CImg<float> & image)
 {
   _errorMessage.clear();
   *_image = image;
+  _scaledPreview = QImage();
   *_savedPreview = image;
   _savedPreviewIsValid = true;
   updateOriginalImagePosition();
@@ -102,7 +102,8 @@ void PreviewWidget::setPreviewErrorMessage(const QString & message)
 void PreviewWidget::setFullImageSize(const QSize & size)
 {
   _fullImageSize = size;
-  _cachedOriginalImagePosition = {-1.0, -1.0, -1.0, -1.0};
+  _originalImagePyramid.clear();
+  _originalImagePyramid.startLoading();
   updateVisibleRect();
   saveVisibleCenter();
 }
@@ -148,16 +149,15 @@ void PreviewWidget::paintEvent(QPaintEvent * e)
 {
   TIMING;
   QPainter painter(this);
-  QImage qimage;
   if (_paintOriginalImage) {
+    updateOriginalImagePosition();
     gmic_image<float> image;
     getOriginalImageCrop(image);
-    updateOriginalImagePosition();
-    image.resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1);
     if (hasAlphaChannel(image)) {
       painter.fillRect(_imagePosition, QBrush(_transparency));
     }
-    ImageConverter::convert(image, qimage);
+    QImage qimage;
+    ImageConverter::convert(image, qimage, _imagePosition.size());
     painter.drawImage(_imagePosition, qimage);
   } else {
     // Display the preview
@@ -183,8 +183,11 @@ void PreviewWidget::paintEvent(QPaintEvent * e)
     if (hasAlphaChannel(*_image)) {
       painter.fillRect(_imagePosition, QBrush(_transparency));
     }
-    ImageConverter::convert(_image->get_resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1), qimage);
-    painter.drawImage(_imagePosition, qimage);
+    // Expose events only need to blit the display image
+    if (_scaledPreview.size() != _imagePosition.size()) {
+      ImageConverter::convert(*_image, _scaledPreview, _imagePosition.size());
+    }
+    painter.drawImage(_imagePosition, _scaledPreview);
     if (!_errorMessage.isEmpty()) { // TODO : Check this
       painter.fillRect(_imagePosition, QColor(40, 40, 40, 150));
       painter.setPen(Qt::green);
@@ -556,31 +559,12 @@ void PreviewWidget::displayOriginalImage()
 
 QSize PreviewWidget::originalImageCropSize()
 {
-  if (_visibleRect != _cachedOriginalImagePosition) {
-    updateCachedOriginalImageCrop();
-  }
-  return QSize(_cachedOriginalImage->width(), _cachedOriginalImage->height());
-}
-
-void PreviewWidget::updateCachedOriginalImageCrop()
-{
-  gmic_list<float> images;
-  gmic_list<char> imageNames;
-  gmic_qt_get_cropped_images(images, imageNames, _visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h, GmicQt::Active);
-  if (images.size() > 0) {
-    gmic_qt_apply_color_profile(images[0]);
-    _cachedOriginalImage->swap(images[0]);
-    _cachedOriginalImagePosition = _visibleRect;
-  }
+  return _originalImagePyramid.cropRect(_visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h).size();
 }
 
 void PreviewWidget::getOriginalImageCrop(cimg_library::CImg<float> & image)
 {
-  if (_visibleRect == _cachedOriginalImagePosition) {
-    image = *_cachedOriginalImage;
-  }
-  updateCachedOriginalImageCrop();
-  image = *_cachedOriginalImage;
+  _originalImagePyramid.getCrop(_visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h, _imagePosition.size(), image);
 }
 
 void PreviewWidget::onPreviewParametersChanged()
@@ -630,6 +614,7 @@ void PreviewWidget::invalidateSavedPreview()
 void PreviewWidget::restorePreview()
 {
   *_image = *_savedPreview;
+  _scaledPreview = QImage();
 }
 
 void PreviewWidget::enableRightClick()
@@ -31,8 +31,8 @@
 #include <QRect>
 #include <QSize>
 #include <QWidget>
-#include <memory>
 #include "Host/host.h"
+#include "ImagePyramid.h"
 
 namespace cimg_library
 {
@@ -105,13 +105,13 @@ public slots:
 
 private:
   void getOriginalImageCrop(cimg_library::CImg<float> & image);
-  void updateCachedOriginalImageCrop();
   void updateOriginalImagePosition();
   QSize originalImageCropSize();
   double defaultZoomFactor() const;
   void saveVisibleCenter();
   cimg_library::CImg<float> * _image;
   cimg_library::CImg<float> * _savedPreview;
+  QImage _scaledPreview; // _image, resized to _imagePosition and ready to be painted
   QSize _fullImageSize;
   double _currentZoomFactor;
 
@@ -162,8 +162,7 @@ private:
   QSize _originalImageSize;
   QSize _originaImageScaledSize;
   bool _rightClickEnabled;
-  std::unique_ptr<cimg_library::CImg<float>> _cachedOriginalImage;
-  PreviewRect _cachedOriginalImagePosition;
+  ImagePyramid _originalImagePyramid;
   QString _errorMessage;
 };
 
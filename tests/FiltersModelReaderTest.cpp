@@ -0,0 +1,118 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersModelReaderTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <iostream>
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "GmicStdlib.h"
+#include "ReferenceFiltersModelReader.h"
+
+/*
+ * Filters read by FiltersModelReader (single-pass scanner) must be exactly
+ * those read by the former regular expression based parser, both from the
+ * bundled stdlib and from a few hand-written corner cases.
+ */
+
+namespace
+{
+const char * CornerCases = "#@gui Top folder\n"
+                           "#@gui Filter one : cmd_one, cmd_one_preview(0.5)+\n"
+                           "#@gui : Size = int(3,1,10)\n"
+                           "\n"
+                           "#@gui : Text = text(\"a, b : c\")\n"
+                           "# Some comment\n"
+                           "#@gui : sep = separator()\n"
+                           "#@gui_en Filter two:cmd_two,cmd_two_preview(0)\n"
+                           "#@gui_en : Amount = float(0.5,0,1)\n"
+                           "#@gui_fr Filtre deux : cmd_two\n"
+                           "#@gui_fr : Quantite = float(0.5,0,1)\n"
+                           "   #@gui   !Indented warning filter  :  cmd_three  \n"
+                           "#@gui : Choice = choice(\"A\",\"B\")\n"
+                           "#@gui _Sub folder\n"
+                           "#@gui No preview : cmd_four\n"
+                           "#@gui __Back to root\n"
+                           "#@gui No parameters : cmd_five, cmd_five_preview(2)\n"
+                           "cmd_five :\n"
+                           "  echo five\n"
+                           "#@gui ___\n"
+                           "#@gui Last filter : _none_, cmd_six(1)+\n"
+                           "#@gui : note = note(\"Last\")";
+
+bool compare(const QString & what, const QString & field, const QString & expected, const QString & value)
+{
+  if (expected == value) {
+    return true;
+  }
+  std::cerr << what.toLocal8Bit().constData() << ": " << field.toLocal8Bit().constData() << " differs\n"
+            << "  expected: " << expected.toLocal8Bit().constData() << "\n"
+            << "  got:      " << value.toLocal8Bit().constData() << "\n";
+  return false;
+}
+
+bool compareModels(const QString & source, QByteArray stdlib)
+{
+  FiltersModel expected;
+  FiltersModel model;
+  ReferenceFiltersModelReader(expected).parseFiltersDefinitions(stdlib);
+  FiltersModelReader(model).parseFiltersDefinitions(stdlib);
+  if (model.filterCount() != expected.filterCount()) {
+    std::cerr << source.toLocal8Bit().constData() << ": " << model.filterCount() << " filters read, " << expected.filterCount() << " expected\n";
+    return false;
+  }
+  bool ok = true;
+  for (size_t index = 0; index < expected.filterCount(); ++index) {
+    const FiltersModel::Filter & a = expected.getFilter(index);
+    const FiltersModel::Filter & b = model.getFilter(index);
+    const QString what = QString("%1, filter #%2 (%3)").arg(source).arg(index).arg(a.plainText());
+    ok = compare(what, "hash", a.hash(), b.hash()) && ok;
+    ok = compare(what, "name", a.name(), b.name()) && ok;
+    ok = compare(what, "path", QStringList(a.path()).join("/"), QStringList(b.path()).join("/")) && ok;
+    ok = compare(what, "command", a.command(), b.command()) && ok;
+    ok = compare(what, "preview command", a.previewCommand(), b.previewCommand()) && ok;
+    ok = compare(what, "preview factor", QString::number(a.previewFactor()), QString::number(b.previewFactor())) && ok;
+    ok = compare(what, "accurate if zoomed", QString::number(a.isAccurateIfZoomed()), QString::number(b.isAccurateIfZoomed())) && ok;
+    ok = compare(what, "warning", QString::number(a.isWarning()), QString::number(b.isWarning())) && ok;
+    ok = compare(what, "parameters", a.parameters(), b.parameters()) && ok;
+  }
+  std::cout << source.toLocal8Bit().constData() << ": " << expected.filterCount() << " filters " << (ok ? "match" : "DIFFER") << "\n";
+  return ok;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  bool ok = compareModels("corner cases", QByteArray(CornerCases));
+  GmicStdLib::loadStdLib();
+  if (GmicStdLib::Array.isEmpty()) {
+    std::cerr << "Could not load the stdlib\n";
+    return 1;
+  }
+  ok = compareModels("stdlib", GmicStdLib::Array) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file GmicStdlibTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QByteArray>
+#include <QList>
+#include <iostream>
+#include "GmicStdlib.h"
+
+/*
+ * GmicStdLib::commandMentions() follows the calls between stdlib commands,
+ * and is conservative for commands it does not know.
+ */
+
+namespace
+{
+const char * Stdlib = "#@gui Filter : fx_filter, fx_filter\n"
+                      "# fx_filter : not a definition\n"
+                      "fx_filter :\n"
+                      "  _fx_helper $1\n"
+                      "  blur 3\n"
+                      "_fx_helper : if $_preview_width>0 resize2dx $_preview_width fi\n"
+                      "fx_plain :\n"
+                      "  blur 3\n"
+                      "  fx_plain_helper\n"
+                      "fx_plain_helper :\n"
+                      "  sharpen 10\n";
+
+bool check(const char * what, bool value, bool expected)
+{
+  if (value != expected) {
+    std::cerr << what << ": got " << value << ", expected " << expected << "\n";
+  }
+  return value == expected;
+}
+}
+
+int main()
+{
+  GmicStdLib::Array = QByteArray(Stdlib);
+  const QList<QByteArray> variables = QList<QByteArray>() << "_preview_width" << "_preview_height";
+  bool ok = true;
+  ok = check("fx_filter", GmicStdLib::commandMentions("fx_filter", variables), true) && ok;
+  ok = check("-fx_filter", GmicStdLib::commandMentions("-fx_filter", variables), true) && ok;
+  ok = check("_fx_helper", GmicStdLib::commandMentions("_fx_helper", variables), true) && ok;
+  ok = check("fx_plain", GmicStdLib::commandMentions("fx_plain", variables), false) && ok;
+  ok = check("unknown", GmicStdLib::commandMentions("fx_unknown", variables), true) && ok;
+  GmicStdLib::Array = QByteArray("fx_filter :\n  blur 3\n");
+  ok = check("fx_filter, new stdlib", GmicStdLib::commandMentions("fx_filter", variables), false) && ok;
+  return ok ? 0 : 1;
+}
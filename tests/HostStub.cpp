@@ -0,0 +1,103 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file HostStub.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "HostStub.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "Host/host.h"
+#include "gmic_qt.h"
+
+namespace GmicQt
+{
+const QString HostApplicationName;
+const char * HostApplicationShortname = "stub";
+}
+
+namespace HostStub
+{
+gmic_image<float> InputImage;
+gmic_list<float> OutputImages;
+}
+
+void gmic_qt_get_image_size(int * width, int * height)
+{
+  *width = HostStub::InputImage.width();
+  *height = HostStub::InputImage.height();
+}
+
+void gmic_qt_get_layers_extent(int * width, int * height, GmicQt::InputMode)
+{
+  gmic_qt_get_image_size(width, height);
+}
+
+void gmic_qt_get_cropped_images(gmic_list<float> & images, gmic_list<char> & imageNames, double x, double y, double width, double height, GmicQt::InputMode mode)
+{
+  if (mode == GmicQt::NoInput) {
+    images.assign();
+    imageNames.assign();
+    return;
+  }
+  const gmic_image<float> & input = HostStub::InputImage;
+  const bool entireImage = x < 0 && y < 0 && width < 0 && height < 0;
+  const int ix = static_cast<int>(entireImage ? 0 : std::floor(x * input.width()));
+  const int iy = static_cast<int>(entireImage ? 0 : std::floor(y * input.height()));
+  const int iw = entireImage ? input.width() : std::min(input.width() - ix, static_cast<int>(1 + std::ceil(width * input.width())));
+  const int ih = entireImage ? input.height() : std::min(input.height() - iy, static_cast<int>(1 + std::ceil(height * input.height())));
+  images.assign(1);
+  imageNames.assign(1);
+  input.get_crop(ix, iy, ix + iw - 1, iy + ih - 1).move_to(images[0]);
+  gmic_image<char>::string("pos(0,0),name(stub)").move_to(imageNames[0]);
+}
+
+void gmic_qt_output_images(gmic_list<float> & images, const gmic_list<char> &, GmicQt::OutputMode, const char *)
+{
+  HostStub::OutputImages.assign(images);
+}
+
+bool gmic_qt_begin_tiled_output(int width, int height, int spectrum, const gmic_list<char> &, GmicQt::OutputMode, const char *)
+{
+  HostStub::OutputImages.assign(1);
+  HostStub::OutputImages[0].assign(width, height, 1, spectrum);
+  return true;
+}
+
+void gmic_qt_output_tile(gmic_image<float> & tile, int x, int y)
+{
+  HostStub::OutputImages[0].draw_image(x, y, tile);
+}
+
+void gmic_qt_end_tiled_output(bool commit)
+{
+  if (!commit) {
+    HostStub::OutputImages.assign();
+  }
+}
+
+void gmic_qt_apply_color_profile(gmic_image<float> &) {}
+
+void gmic_qt_show_message(const char * message)
+{
+  std::cout << message << std::endl;
+}
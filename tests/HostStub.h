@@ -0,0 +1,43 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file HostStub.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_HOSTSTUB_H_
+#define _GMIC_QT_HOSTSTUB_H_
+
+#include "gmic.h"
+
+/**
+ * In-memory host application used by the tests and the benchmarks, in place
+ * of the GIMP, Krita or standalone host. It holds a single layer.
+ */
+namespace HostStub
+{
+// Layer returned by gmic_qt_get_cropped_images()
+extern gmic_image<float> InputImage;
+
+// Images received by the last call to gmic_qt_output_images()
+extern gmic_list<float> OutputImages;
+}
+
+#endif // _GMIC_QT_HOSTSTUB_H_
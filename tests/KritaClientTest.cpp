@@ -0,0 +1,130 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KritaClientTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+#include <iostream>
+#include "Host/Krita/KritaClient.h"
+#include "MockKritaServer.h"
+#include "gmic.h"
+
+/*
+ * KritaClient against the mock Krita server: a server knowing only protocol 1
+ * gets one connection per message, a server knowing protocol 2 gets a single
+ * session. Both must yield the same images, in both directions.
+ */
+
+namespace
+{
+const int Width = 640;
+const int Height = 480;
+
+float pattern(int x, int y, int c)
+{
+  return float((x + 3 * y + 7 * c) % 256);
+}
+
+bool check(const char * what, long value, long expected)
+{
+  if (value != expected) {
+    std::cerr << what << ": got " << value << ", expected " << expected << "\n";
+  }
+  return value == expected;
+}
+
+bool checkProtocol(int protocol, const gmic_image<float> & layer)
+{
+  const QString key = QString("gmic-qt-krita-client-test-%1-%2").arg(QCoreApplication::applicationPid()).arg(protocol);
+  MockKritaServer server(key, protocol, layer);
+  if (!server.listen()) {
+    std::cerr << "Could not start the mock server\n";
+    return false;
+  }
+  KritaClient client(key);
+  bool ok = check("protocol", client.protocol(), protocol);
+  const int rounds = 3;
+  for (int round = 0; round < rounds; ++round) {
+    int width, height;
+    ok = check("layers extent", client.getLayersExtent(1, width, height), true) && ok;
+    ok = check("width", width, Width) && ok;
+    ok = check("height", height, Height) && ok;
+    gmic_list<float> images;
+    gmic_list<char> names;
+    ok = check("cropped images", client.getCroppedImages(1, 0.25, 0.5, 0.5, 0.25, images, names), true) && ok;
+    if (!check("image count", images.size(), 1) || !check("name count", names.size(), 1)) {
+      return false;
+    }
+    // Same rounding as Krita: floor of the origin, one more pixel than the ceiling of the size
+    const gmic_image<float> & image = images[0];
+    ok = check("crop width", image.width(), 321) && ok;
+    ok = check("crop height", image.height(), 121) && ok;
+    ok = check("crop spectrum", image.spectrum(), 4) && ok;
+    if (image.width() == 321 && image.height() == 121 && image.spectrum() == 4) {
+      for (int c = 0; c < 4; ++c) {
+        ok = check("top left pixel", long(image(0, 0, 0, c)), long(pattern(160, 240, c))) && ok;
+        ok = check("bottom right pixel", long(image(320, 120, 0, c)), long(pattern(480, 360, c))) && ok;
+      }
+    }
+    ok = check("name", QString(names[0].data()) == "mode(normal),opacity(1),pos(0,0),name(Background)", true) && ok;
+  }
+  gmic_list<float> outputs(2);
+  gmic_list<char> outputNames(2);
+  outputs[0].assign(64, 32, 1, 4).rand(0, 255);
+  outputs[1].assign(17, 45, 1, 3).rand(0, 255);
+  gmic_image<char>::string("name(first)").move_to(outputNames[0]);
+  gmic_image<char>::string("name(second)").move_to(outputNames[1]);
+  ok = check("output images", client.outputImages(outputs, outputNames, 0), true) && ok;
+  const gmic_list<float> received = server.outputImages();
+  if (check("received image count", received.size(), 2) && check("received name count", server.outputNames().size(), 2)) {
+    for (int i = 0; i < 2; ++i) {
+      ok = check("received image", received[i] == outputs[i], true) && ok;
+      ok = check("received name", server.outputNames()[i] == QByteArray(outputNames[i].data()), true) && ok;
+    }
+  } else {
+    ok = false;
+  }
+  client.releaseOutputSegments();
+
+  // Answered after the last detach, which is only posted in a session
+  int width, height;
+  ok = check("last layers extent", client.getLayersExtent(1, width, height), true) && ok;
+  ok = check("released segments", server.segmentCount(), 0) && ok;
+  const int messages = 1 + 3 * rounds + 2;
+  ok = check("messages", server.messageCount(), messages) && ok;
+  ok = check("connections", server.connectionCount(), (protocol == 2) ? 1 : messages) && ok;
+  client.close();
+  return ok;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  QCoreApplication app(argc, argv);
+  gmic_image<float> layer(Width, Height, 1, 4);
+  cimg_forXYC(layer, x, y, c) { layer(x, y, 0, c) = pattern(x, y, c); }
+  bool ok = checkProtocol(1, layer);
+  ok = checkProtocol(2, layer) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file LoopbackHttpServer.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "LoopbackHttpServer.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QLocale>
+#include <QPointer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+
+LoopbackHttpServer::LoopbackHttpServer(QObject * parent) : QObject(parent), _delay(0)
+{
+  resetCounters();
+  connect(&_server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+}
+
+bool LoopbackHttpServer::listen()
+{
+  return _server.listen(QHostAddress::LocalHost);
+}
+
+QString LoopbackHttpServer::url(const QString & path) const
+{
+  return QString("http://127.0.0.1:%1/%2").arg(_server.serverPort()).arg(path);
+}
+
+void LoopbackHttpServer::setFile(const QString & path, const QByteArray & content)
+{
+  File & file = _files[path];
+  if (file.content == content && !file.etag.isEmpty()) {
+    return;
+  }
+  file.content = content;
+  file.etag = "\"" + QCryptographicHash::hash(content, QCryptographicHash::Md5).toHex() + "\"";
+  file.lastModified = QLocale::c().toString(QDateTime::currentDateTimeUtc(), "ddd, dd MMM yyyy hh:mm:ss 'GMT'").toLatin1();
+}
+
+void LoopbackHttpServer::setDelay(int delay)
+{
+  _delay = delay;
+}
+
+void LoopbackHttpServer::interruptNextAnswer(const QString & path, int bytes)
+{
+  _interruptions[path] = bytes;
+}
+
+void LoopbackHttpServer::resetCounters()
+{
+  _requestCount = 0;
+  _notModifiedCount = 0;
+  _partialCount = 0;
+  _bodyBytes = 0;
+  _requestsInFlight = 0;
+  _maxRequestsInFlight = 0;
+}
+
+int LoopbackHttpServer::requestCount() const
+{
+  return _requestCount;
+}
+
+int LoopbackHttpServer::notModifiedCount() const
+{
+  return _notModifiedCount;
+}
+
+int LoopbackHttpServer::partialCount() const
+{
+  return _partialCount;
+}
+
+qint64 LoopbackHttpServer::bodyBytes() const
+{
+  return _bodyBytes;
+}
+
+int LoopbackHttpServer::maxRequestsInFlight() const
+{
+  return _maxRequestsInFlight;
+}
+
+void LoopbackHttpServer::onNewConnection()
+{
+  while (QTcpSocket * socket = _server.nextPendingConnection()) {
+    connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  }
+}
+
+void LoopbackHttpServer::onReadyRead()
+{
+  QTcpSocket * socket = qobject_cast<QTcpSocket *>(sender());
+  if (!socket) {
+    return;
+  }
+  QByteArray & request = _requests[socket];
+  request += socket->readAll();
+  if (!request.contains("\r\n\r\n")) {
+    return;
+  }
+  const QByteArray header = _requests.take(socket);
+  ++_requestCount;
+  _requestsInFlight += 1;
+  _maxRequestsInFlight = std::max(_maxRequestsInFlight, _requestsInFlight);
+  QPointer<QTcpSocket> pointer(socket);
+  QTimer::singleShot(_delay, this, [this, pointer, header]() {
+    --_requestsInFlight;
+    if (pointer) {
+      answer(pointer, header);
+    }
+  });
+}
+
+void LoopbackHttpServer::answer(QTcpSocket * socket, const QByteArray & request)
+{
+  QList<QByteArray> lines = request.split('\n');
+  const QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+  QMap<QByteArray, QByteArray> headers;
+  for (const QByteArray & line : lines) {
+    const int colon = line.indexOf(':');
+    if (colon > 0) {
+      headers[line.left(colon).trimmed().toLower()] = line.mid(colon + 1).trimmed();
+    }
+  }
+  const QString path = (requestLine.size() > 1) ? QString::fromUtf8(requestLine[1].mid(1)) : QString();
+  if (requestLine[0] != "GET" || !_files.contains(path)) {
+    socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    socket->disconnectFromHost();
+    return;
+  }
+  const File & file = _files[path];
+  const QByteArray validators = "ETag: " + file.etag + "\r\nLast-Modified: " + file.lastModified + "\r\n";
+  const bool notModified = headers.contains("if-none-match") ? (headers["if-none-match"] == file.etag) : (headers.value("if-modified-since") == file.lastModified);
+  if (notModified) {
+    ++_notModifiedCount;
+    socket->write("HTTP/1.1 304 Not Modified\r\n" + validators + "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    socket->disconnectFromHost();
+    return;
+  }
+
+  int offset = 0;
+  const QByteArray range = headers.value("range");
+  const QByteArray ifRange = headers.value("if-range");
+  if (range.startsWith("bytes=") && range.endsWith("-") && (ifRange.isEmpty() || ifRange == file.etag || ifRange == file.lastModified)) {
+    offset = range.mid(6, range.size() - 7).toInt();
+    if (offset <= 0 || offset >= file.content.size()) {
+      offset = 0;
+    }
+  }
+  QByteArray body = file.content.mid(offset);
+  QByteArray response;
+  if (offset) {
+    ++_partialCount;
+    response = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + QByteArray::number(offset) + "-" + QByteArray::number(file.content.size() - 1) + "/" +
+               QByteArray::number(file.content.size()) + "\r\n";
+  } else {
+    response = "HTTP/1.1 200 OK\r\n";
+  }
+  response += validators + "Accept-Ranges: bytes\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n";
+  if (_interruptions.contains(path)) {
+    body.truncate(_interruptions.take(path));
+  }
+  _bodyBytes += body.size();
+  socket->write(response + body);
+  socket->disconnectFromHost();
+}
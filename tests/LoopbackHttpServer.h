@@ -0,0 +1,87 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file LoopbackHttpServer.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_LOOPBACKHTTPSERVER_H_
+#define _GMIC_QT_LOOPBACKHTTPSERVER_H_
+
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+/**
+ * Minimal HTTP/1.1 server on the loopback interface, standing in for the
+ * servers of the filter sources in the tests of the Updater. It serves
+ * files from memory, one request per connection, and honours conditional
+ * (If-None-Match, If-Modified-Since) and range (Range, If-Range) requests.
+ * It runs in the event loop of the thread that created it.
+ */
+class LoopbackHttpServer : public QObject {
+  Q_OBJECT
+public:
+  explicit LoopbackHttpServer(QObject * parent = nullptr);
+  bool listen();
+  QString url(const QString & path) const;
+  // Serve content at path, with a new validator if the content changed
+  void setFile(const QString & path, const QByteArray & content);
+  // Delay before each answer, in milliseconds
+  void setDelay(int delay);
+  // Close the connection of the next answer for path after some bytes of its body
+  void interruptNextAnswer(const QString & path, int bytes);
+
+  void resetCounters();
+  int requestCount() const;
+  int notModifiedCount() const;
+  int partialCount() const;
+  qint64 bodyBytes() const;
+  int maxRequestsInFlight() const;
+
+private slots:
+  void onNewConnection();
+  void onReadyRead();
+
+private:
+  void answer(QTcpSocket * socket, const QByteArray & request);
+  struct File {
+    QByteArray content;
+    QByteArray etag;
+    QByteArray lastModified;
+  };
+  QTcpServer _server;
+  QMap<QString, File> _files;
+  QMap<QString, int> _interruptions;
+  QMap<QTcpSocket *, QByteArray> _requests;
+  int _delay;
+  int _requestCount;
+  int _notModifiedCount;
+  int _partialCount;
+  qint64 _bodyBytes;
+  int _requestsInFlight;
+  int _maxRequestsInFlight;
+};
+
+#endif // _GMIC_QT_LOOPBACKHTTPSERVER_H_
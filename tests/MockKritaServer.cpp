@@ -0,0 +1,269 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file MockKritaServer.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "MockKritaServer.h"
+#include <QDataStream>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutexLocker>
+#include <QSharedMemory>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "Host/Krita/KritaClient.h"
+
+MockKritaServer::MockKritaServer(const QString & socketKey, int protocol, const gmic_image<float> & layer)
+    : _socketKey(socketKey), _protocol(protocol), _layer(layer), _listening(false), _stopping(0), _connectionCount(0), _messageCount(0), _segmentCount(0), _nextSegment(0)
+{
+}
+
+MockKritaServer::~MockKritaServer()
+{
+  stop();
+}
+
+bool MockKritaServer::listen()
+{
+  start();
+  _started.acquire();
+  return _listening;
+}
+
+void MockKritaServer::stop()
+{
+  _stopping.store(1);
+  wait();
+}
+
+int MockKritaServer::connectionCount() const
+{
+  return _connectionCount.load();
+}
+
+int MockKritaServer::messageCount() const
+{
+  return _messageCount.load();
+}
+
+int MockKritaServer::segmentCount() const
+{
+  return _segmentCount.load();
+}
+
+gmic_list<float> MockKritaServer::outputImages() const
+{
+  QMutexLocker locker(&_outputMutex);
+  return _outputImages;
+}
+
+QList<QByteArray> MockKritaServer::outputNames() const
+{
+  QMutexLocker locker(&_outputMutex);
+  return _outputNames;
+}
+
+void MockKritaServer::run()
+{
+  QLocalServer server;
+  QLocalServer::removeServer(_socketKey);
+  _listening = server.listen(_socketKey);
+  _started.release();
+  while (_listening && !_stopping.load()) {
+    if (server.waitForNewConnection(100)) {
+      while (QLocalSocket * socket = server.nextPendingConnection()) {
+        serve(*socket);
+        delete socket;
+      }
+    }
+  }
+  releaseSegments();
+}
+
+void MockKritaServer::serve(QLocalSocket & socket)
+{
+  _connectionCount.ref();
+  QByteArray message;
+  if (!readBytes(socket, message)) {
+    return;
+  }
+  _messageCount.ref();
+  const bool session = (_protocol == 2) && (message == KritaClient::HelloMessage);
+  const QByteArray reply = session ? QByteArray("protocol=2") : answer(message, false);
+  QDataStream(&socket).writeBytes(reply.constData(), reply.length());
+  socket.waitForBytesWritten(1000);
+  if (!waitForBytes(socket, 3) || (socket.read(3) != "ack") || !session) {
+    return;
+  }
+  quint32 id;
+  QByteArray payload;
+  while (readUInt32(socket, id) && readBytes(socket, payload)) {
+    _messageCount.ref();
+    const QByteArray reply = answer(payload, true);
+    QByteArray frame;
+    QDataStream out(&frame, QIODevice::WriteOnly);
+    out << id;
+    out.writeBytes(reply.constData(), reply.length());
+    socket.write(frame);
+    socket.waitForBytesWritten(1000);
+  }
+}
+
+QByteArray MockKritaServer::answer(const QByteArray & message, bool binary)
+{
+  QByteArray command;
+  QByteArray croprect;
+  QList<QByteArray> layers;
+  for (const QByteArray & line : message.split('\n')) {
+    if (line.startsWith("command=")) {
+      command = line.mid(8);
+    } else if (line.startsWith("croprect=")) {
+      croprect = line.mid(9);
+    } else if (line.startsWith("layer=")) {
+      layers.push_back(line.mid(6));
+    }
+  }
+  if (command == "gmic_qt_get_image_size") {
+    if (binary) {
+      QByteArray answer;
+      QDataStream(&answer, QIODevice::WriteOnly) << qint32(_layer.width()) << qint32(_layer.height());
+      return answer;
+    }
+    return QByteArray::number(_layer.width()) + "," + QByteArray::number(_layer.height());
+  }
+  if (command == "gmic_qt_get_cropped_images") {
+    return croppedImages(croprect, binary);
+  }
+  if (command == "gmic_qt_output_images") {
+    readOutputImages(layers);
+  } else if (command == "gmic_qt_detach") {
+    releaseSegments();
+  }
+  // Like Krita, answer unknown commands with an empty message
+  return QByteArray();
+}
+
+QByteArray MockKritaServer::croppedImages(const QByteArray & croprect, bool binary)
+{
+  const QList<QByteArray> rect = croprect.split(',');
+  if (rect.size() != 4) {
+    return QByteArray();
+  }
+  const int ix = static_cast<int>(std::floor(rect[0].toDouble() * _layer.width()));
+  const int iy = static_cast<int>(std::floor(rect[1].toDouble() * _layer.height()));
+  const int iw = std::min(_layer.width() - ix, static_cast<int>(1 + std::ceil(rect[2].toDouble() * _layer.width())));
+  const int ih = std::min(_layer.height() - iy, static_cast<int>(1 + std::ceil(rect[3].toDouble() * _layer.height())));
+  if (ix < 0 || iy < 0 || iw <= 0 || ih <= 0) {
+    return QByteArray();
+  }
+  const gmic_image<float> crop = _layer.get_crop(ix, iy, ix + iw - 1, iy + ih - 1);
+
+  QSharedMemory * segment = new QSharedMemory(QString("%1_segment_%2").arg(_socketKey).arg(_nextSegment++));
+  if (!segment->create(static_cast<int>(crop.size() * sizeof(float)))) {
+    delete segment;
+    return QByteArray();
+  }
+  segment->lock();
+  std::memcpy(segment->data(), crop.data(), crop.size() * sizeof(float));
+  segment->unlock();
+  _segments.push_back(segment);
+  _segmentCount.ref();
+
+  const QByteArray key = segment->key().toUtf8();
+  const QByteArray name("mode(normal),opacity(1),pos(0,0),name(Background)");
+  if (binary) {
+    QByteArray answer;
+    QDataStream(&answer, QIODevice::WriteOnly) << quint32(1) << key << name << qint32(crop.width()) << qint32(crop.height()) << qint32(crop.spectrum());
+    return answer;
+  }
+  return key + "," + name.toHex() + "," + QByteArray::number(crop.width()) + "," + QByteArray::number(crop.height()) + "\n";
+}
+
+void MockKritaServer::readOutputImages(const QList<QByteArray> & layers)
+{
+  gmic_list<float> images(layers.size());
+  QList<QByteArray> names;
+  for (int i = 0; i < layers.size(); ++i) {
+    // key,hexname,spectrum,width,height
+    const QList<QByteArray> parts = layers[i].split(',');
+    names.push_back(parts.size() == 5 ? QByteArray::fromHex(parts[1]) : QByteArray());
+    if (parts.size() != 5) {
+      continue;
+    }
+    QSharedMemory segment(QString::fromUtf8(parts[0]));
+    if (!segment.attach(QSharedMemory::ReadOnly)) {
+      continue;
+    }
+    gmic_image<float> & image = images[i];
+    image.assign(parts[3].toInt(), parts[4].toInt(), 1, parts[2].toInt());
+    if (static_cast<size_t>(segment.size()) >= image.size() * sizeof(float)) {
+      segment.lock();
+      std::memcpy(image.data(), segment.constData(), image.size() * sizeof(float));
+      segment.unlock();
+    } else {
+      image.assign();
+    }
+    segment.detach();
+  }
+  QMutexLocker locker(&_outputMutex);
+  images.move_to(_outputImages);
+  _outputNames = names;
+}
+
+void MockKritaServer::releaseSegments()
+{
+  qDeleteAll(_segments);
+  _segments.clear();
+  _segmentCount.store(0);
+}
+
+bool MockKritaServer::waitForBytes(QLocalSocket & socket, qint64 count)
+{
+  while (socket.bytesAvailable() < count) {
+    if (_stopping.load() || (!socket.waitForReadyRead(100) && (socket.state() != QLocalSocket::ConnectedState))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MockKritaServer::readUInt32(QLocalSocket & socket, quint32 & value)
+{
+  uchar bytes[sizeof(quint32)];
+  if (!waitForBytes(socket, sizeof(bytes)) || (socket.read(reinterpret_cast<char *>(bytes), sizeof(bytes)) != sizeof(bytes))) {
+    return false;
+  }
+  value = qFromBigEndian<quint32>(bytes);
+  return true;
+}
+
+bool MockKritaServer::readBytes(QLocalSocket & socket, QByteArray & data)
+{
+  quint32 length;
+  if (!readUInt32(socket, length) || !waitForBytes(socket, length)) {
+    return false;
+  }
+  data = socket.read(length);
+  return data.size() == static_cast<int>(length);
+}
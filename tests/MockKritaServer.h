@@ -0,0 +1,92 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file MockKritaServer.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_MOCKKRITASERVER_H_
+#define _GMIC_QT_MOCKKRITASERVER_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+#include "gmic.h"
+
+class QLocalSocket;
+class QSharedMemory;
+
+/**
+ * Stand-in for the local server of Krita's G'MIC plug-in, used by the tests
+ * and the benchmarks of KritaClient. It serves a single layer, one client at
+ * a time, from its own thread. With protocol 1 it behaves like a Krita that
+ * does not know the hello message; with protocol 2 it accepts sessions.
+ */
+class MockKritaServer : public QThread {
+public:
+  MockKritaServer(const QString & socketKey, int protocol, const gmic_image<float> & layer);
+  ~MockKritaServer() override;
+  /**
+   * @brief Start the server thread.
+   * @return false if the server could not listen to the socket key
+   */
+  bool listen();
+  void stop();
+  int connectionCount() const;
+  int messageCount() const;
+  // Segments created for get_cropped_images and not released by a detach yet
+  int segmentCount() const;
+  // Images and names received by the last gmic_qt_output_images message
+  gmic_list<float> outputImages() const;
+  QList<QByteArray> outputNames() const;
+
+protected:
+  void run() override;
+
+private:
+  void serve(QLocalSocket & socket);
+  QByteArray answer(const QByteArray & message, bool binary);
+  QByteArray croppedImages(const QByteArray & croprect, bool binary);
+  void readOutputImages(const QList<QByteArray> & layers);
+  void releaseSegments();
+  bool waitForBytes(QLocalSocket & socket, qint64 count);
+  bool readUInt32(QLocalSocket & socket, quint32 & value);
+  bool readBytes(QLocalSocket & socket, QByteArray & data);
+  QString _socketKey;
+  int _protocol;
+  gmic_image<float> _layer;
+  QSemaphore _started;
+  bool _listening;
+  QAtomicInt _stopping;
+  QAtomicInt _connectionCount;
+  QAtomicInt _messageCount;
+  QAtomicInt _segmentCount;
+  QList<QSharedMemory *> _segments;
+  int _nextSegment;
+  mutable QMutex _outputMutex;
+  gmic_list<float> _outputImages;
+  QList<QByteArray> _outputNames;
+};
+
+#endif // _GMIC_QT_MOCKKRITASERVER_H_
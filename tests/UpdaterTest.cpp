@@ -0,0 +1,175 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file UpdaterTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QTemporaryDir>
+#include <QThread>
+#include <cstdio>
+#include <iostream>
+#include "LoopbackHttpServer.h"
+#include "Updater.h"
+#include "Utils.h"
+
+/*
+ * Updates of 24 filter sources served by a loopback HTTP server: a first
+ * download, an update where nothing changed (conditional requests only),
+ * an update of a few sources, and an interrupted download that is resumed.
+ * Prints the bytes transferred and the latency of each update.
+ */
+
+namespace
+{
+const int SourceCount = 24;
+
+QByteArray sourceContent(int index, int version)
+{
+  QByteArray content = "#@gmic\n# Source " + QByteArray::number(index) + ", version " + QByteArray::number(version) + "\n";
+  const QByteArray line = "#@gui Filter " + QByteArray::number(index) + " : fx_filter_" + QByteArray::number(index) + ", fx_filter_preview(0)\n";
+  while (content.size() < 40000 + 2000 * index) {
+    content += line;
+  }
+  return content;
+}
+
+QString sourcePath(int index)
+{
+  return QString("source%1.gmic").arg(index);
+}
+
+bool check(const char * what, qint64 value, qint64 expected)
+{
+  if (value != expected) {
+    std::cerr << what << ": got " << value << ", expected " << expected << "\n";
+  }
+  return value == expected;
+}
+
+int runUpdate(const char * title, const QList<QString> & sources, LoopbackHttpServer & server)
+{
+  // Checks of the previous update must be older than the limit (0 hours)
+  QThread::msleep(5);
+  server.resetCounters();
+  Updater * updater = Updater::getInstance();
+  QEventLoop loop;
+  int status = -1;
+  QMetaObject::Connection connection = QObject::connect(updater, &Updater::updateIsDone, [&status, &loop](int result) {
+    status = result;
+    loop.quit();
+  });
+  QElapsedTimer timer;
+  timer.start();
+  updater->startUpdate(sources, 0, 60);
+  if (status == -1) {
+    loop.exec();
+  }
+  QObject::disconnect(connection);
+  std::printf("%-28s %6.1f ms, %8lld bytes, %2d requests (%d not modified, %d partial), %d in flight at most\n", title, timer.nsecsElapsed() / 1e6, server.bodyBytes(),
+              server.requestCount(), server.notModifiedCount(), server.partialCount(), server.maxRequestsInFlight());
+  return status;
+}
+
+bool checkLocalFiles(const QList<QString> & sources, const QList<QByteArray> & contents)
+{
+  bool ok = true;
+  for (int i = 0; i < sources.size(); ++i) {
+    QFile file(QString("%1%2").arg(GmicQt::path_rc(false)).arg(sourcePath(i)));
+    ok = check(qPrintable(sourcePath(i)), file.open(QFile::ReadOnly) && (file.readAll() == contents[i]), true) && ok;
+  }
+  return ok;
+}
+}
+
+int main(int argc, char * argv[])
+{
+  // Keep the downloaded files and the settings away from the user's ones
+  QTemporaryDir home;
+  qputenv("GMIC_PATH", home.path().toLocal8Bit());
+  qputenv("XDG_CONFIG_HOME", home.path().toLocal8Bit());
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setOrganizationName("gmic_qt_updater_test");
+  QCoreApplication::setApplicationName("gmic_qt_updater_test");
+  if (GmicQt::path_rc(true).isEmpty()) {
+    std::cerr << "Could not create the resources directory\n";
+    return 1;
+  }
+
+  LoopbackHttpServer server;
+  if (!server.listen()) {
+    std::cerr << "Could not start the loopback server\n";
+    return 1;
+  }
+  server.setDelay(5);
+  QList<QString> sources;
+  QList<QByteArray> contents;
+  qint64 totalSize = 0;
+  for (int i = 0; i < SourceCount; ++i) {
+    contents.push_back(sourceContent(i, 1));
+    server.setFile(sourcePath(i), contents.back());
+    sources.push_back(server.url(sourcePath(i)));
+    totalSize += contents.back().size();
+  }
+  bool ok = true;
+
+  ok = check("first update status", runUpdate("First update:", sources, server), Updater::UpdateSuccessful) && ok;
+  ok = check("first update bytes", server.bodyBytes(), totalSize) && ok;
+  ok = check("concurrent requests", server.maxRequestsInFlight() <= 2, true) && ok;
+  ok = checkLocalFiles(sources, contents) && ok;
+
+  const QDateTime modified = QFileInfo(QString("%1%2").arg(GmicQt::path_rc(false)).arg(sourcePath(0))).lastModified();
+  ok = check("unchanged update status", runUpdate("Nothing changed:", sources, server), Updater::UpdateSuccessful) && ok;
+  ok = check("unchanged update bytes", server.bodyBytes(), 0) && ok;
+  ok = check("not modified answers", server.notModifiedCount(), SourceCount) && ok;
+  ok = check("untouched file", QFileInfo(QString("%1%2").arg(GmicQt::path_rc(false)).arg(sourcePath(0))).lastModified() == modified, true) && ok;
+
+  qint64 changedSize = 0;
+  for (int i = 0; i < 3; ++i) {
+    contents[i] = sourceContent(i, 2);
+    server.setFile(sourcePath(i), contents[i]);
+    changedSize += contents[i].size();
+  }
+  ok = check("partial update status", runUpdate("Three sources changed:", sources, server), Updater::UpdateSuccessful) && ok;
+  ok = check("partial update bytes", server.bodyBytes(), changedSize) && ok;
+  ok = checkLocalFiles(sources, contents) && ok;
+
+  const int last = SourceCount - 1;
+  const QByteArray previous = contents[last];
+  contents[last] = sourceContent(last, 3);
+  server.setFile(sourcePath(last), contents[last]);
+  server.interruptNextAnswer(sourcePath(last), contents[last].size() / 2);
+  ok = check("interrupted update status", runUpdate("Interrupted download:", sources, server), Updater::SomeUpdatesFailed) && ok;
+  contents[last] = previous;
+  ok = checkLocalFiles(sources, contents) && ok;
+  contents[last] = sourceContent(last, 3);
+  ok = check("resumed update status", runUpdate("Resumed download:", sources, server), Updater::UpdateSuccessful) && ok;
+  ok = check("resumed downloads", server.partialCount(), 1) && ok;
+  ok = check("resumed bytes", server.bodyBytes() < contents[last].size(), true) && ok;
+  ok = checkLocalFiles(sources, contents) && ok;
+  return ok ? 0 : 1;
+}